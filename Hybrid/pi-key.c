@@ -2,58 +2,86 @@
  * By Oak Ridge National Laboratory
  * Source: https://www.olcf.ornl.gov/tutorials/monte-carlo-pi/
  * Modified by Phil List
+ *
+ * Usage: pi-key [-n samples] [-s seed]
+ * The samples are split evenly across all ranks, rank 0 included, and across
+ * the OMP_NUM_THREADS threads of each rank.
  */
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <unistd.h>
+#include <inttypes.h>
 #include "mpi.h"
 #include <omp.h>
-#include <math.h>
-#include <time.h>
+#include "pi-monte-carlo.h"
  
 int main(int argc, char* argv[]) {
 
-    int niter = 1000000;			// number of iterations per FOR loop
+    uint64_t samples = 100000000;		// total number of random points
+    uint64_t seed = 20150601;			// key of the random number generator
+    uint64_t blocks;				// generator calls (2 points each)
+    uint64_t first, last;			// this rank's range of generator calls
+    uint64_t count;				// number of good points on this rank
+    uint64_t reducedcount;			// total number of "good" points from all nodes
     int myid;					// holds process's rank id
-    double x = 0, y = 0;			// x,y value for the random coordinate
-    int i = 0;					// loop counter
-    int count=0;				// Count holds all the number of how many good coordinates
-    double z = 0;				// Used to check if x^2+y^2<=1
-    double pi;					// holds approx value of pi
-    int reducedcount;				// total number of "good" points from all nodes
-    int reducedniter;				// total number of ALL points from all nodes
     int ranknum = 0;				// total number of nodes available
-    int numthreads = 8;
-    omp_set_num_threads(numthreads);
+    double pi;					// holds approx value of pi
+    double start_time, elapsed, max_elapsed;
+    int c;
+
     MPI_Init(&argc, &argv);
     MPI_Comm_rank(MPI_COMM_WORLD, &myid);
     MPI_Comm_size(MPI_COMM_WORLD, &ranknum);
- 
-    if(myid != 0) {					// Do the following on all except the master node
-        
-        #pragma omp parallel firstprivate(x, y, z, i) reduction(+:count)
-        {
-            srandom((int)time(NULL) ^ omp_get_thread_num());    //Give random() a seed value
-            for (i=0; i<niter; ++i) {
-                x = (double)random()/RAND_MAX;      //gets a random x coordinate
-                y = (double)random()/RAND_MAX;      //gets a random y coordinate
-                z = sqrt((x*x)+(y*y));          //Checks to see if number is inside unit circle
-                if (z<=1){
-                    ++count;            //if it is, consider it a valid random point
+
+    while ((c = getopt(argc, argv, "n:s:")) != -1) {
+        switch (c) {
+            case 'n':
+                samples = strtoull(optarg, NULL, 10);
+                break;
+            case 's':
+                seed = strtoull(optarg, NULL, 10);
+                break;
+            default:
+                if (myid == 0) {
+                    fprintf(stderr, "Usage: %s [-n samples] [-s seed]\n",
+                            argv[0]);
                 }
-            }
+                MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
         }
     }
+
+    blocks = (samples + POINTS_PER_BLOCK - 1) / POINTS_PER_BLOCK;
+    samples = blocks * POINTS_PER_BLOCK;
+
+    /* Every rank, including the master, takes a contiguous range of the
+     * generator's counters */
+    first = blocks / ranknum * myid + ((uint64_t)myid < blocks % ranknum ?
+                                       (uint64_t)myid : blocks % ranknum);
+    last = first + blocks / ranknum +
+           ((uint64_t)myid < blocks % ranknum ? 1 : 0);
+
     MPI_Barrier(MPI_COMM_WORLD);
-    MPI_Reduce(&count, &reducedcount, 1, MPI_INT, MPI_SUM, 0, MPI_COMM_WORLD);
-    reducedniter = numthreads*niter*(ranknum-1);
- 
+    start_time = MPI_Wtime();
+
+    count = countHits(seed, first, last);
+
+    MPI_Reduce(&count, &reducedcount, 1, MPI_UINT64_T, MPI_SUM, 0,
+               MPI_COMM_WORLD);
+    elapsed = MPI_Wtime() - start_time;
+    MPI_Reduce(&elapsed, &max_elapsed, 1, MPI_DOUBLE, MPI_MAX, 0,
+               MPI_COMM_WORLD);
+
     if (myid == 0) {                      // if root process/master node
-        pi = ((double)reducedcount/(double)reducedniter)*4.0;
-        printf("Pi: %f\n%i\n%d\n", pi, reducedcount, reducedniter);
+        pi = estimatePi(reducedcount, samples);
+        printf("Pi: %.12f +/- %.12f\n", pi,
+               standardError(reducedcount, samples));
+        printf("%" PRIu64 "\n%" PRIu64 "\n", reducedcount, samples);
+        printf("Ranks: %d, threads per rank: %d, time: %f s, "
+               "samples per second: %e\n", ranknum, omp_get_max_threads(),
+               max_elapsed, (double)samples / max_elapsed);
     }
  
     MPI_Finalize();                     //Close the MPI instance
     return 0;
 }
-
@@ -0,0 +1,112 @@
+/* Parallelization: Pi
+ * Monte Carlo engine shared by pi-openmp.c and pi-key.c
+ *
+ * Random points come from Philox4x32-10, a counter-based generator (Salmon et
+ * al., "Parallel Random Numbers: As Easy as 1, 2, 3", SC 2011): the n-th
+ * output is a pure function of (seed, n), so there is no shared state to lock
+ * and every thread of every rank reads its own disjoint range of counters.
+ * Because the ranges only depend on the sample count, the estimate is the
+ * same for any number of ranks and threads.
+ *
+ * Each call of the generator gives four 32-bit words, i.e. two points.  The
+ * coordinates are 31-bit integers in [0, 2^31), and a point is inside the
+ * quarter circle when x*x + y*y < 2^62, which is exact in 64-bit integer
+ * arithmetic (no sqrt(), no floating point) and vectorises.
+ */
+#ifndef PI_MONTE_CARLO_H
+#define PI_MONTE_CARLO_H
+
+#include <stdint.h>
+#include <math.h>
+
+#define PHILOX_M0 0xD2511F53u
+#define PHILOX_M1 0xCD9E8D57u
+#define PHILOX_W0 0x9E3779B9u
+#define PHILOX_W1 0xBB67AE85u
+
+/* Points per call of the generator */
+#define POINTS_PER_BLOCK 2
+
+/* Generator calls per SIMD batch */
+#define BATCH_BLOCKS 4096
+
+#define RADIUS_SQ (((uint64_t)1) << 62)
+
+/* Count how many of the points generated from counters first, first+1, ...,
+ * first+count-1 fall inside the quarter circle */
+static inline uint64_t countHitsInBatch(const uint64_t seed,
+                                        const uint64_t first,
+                                        const int count) {
+    uint64_t hits = 0;
+    int b;
+
+    #pragma omp simd reduction(+:hits)
+    for (b = 0; b < count; b++) {
+        const uint64_t counter = first + b;
+        uint32_t c0 = (uint32_t)counter;
+        uint32_t c1 = (uint32_t)(counter >> 32);
+        uint32_t c2 = 0;
+        uint32_t c3 = 0;
+        uint32_t k0 = (uint32_t)seed;
+        uint32_t k1 = (uint32_t)(seed >> 32);
+        uint64_t x, y;
+        int round;
+
+        for (round = 0; round < 10; round++) {
+            const uint64_t p0 = (uint64_t)PHILOX_M0 * c0;
+            const uint64_t p1 = (uint64_t)PHILOX_M1 * c2;
+            const uint32_t n0 = (uint32_t)(p1 >> 32) ^ c1 ^ k0;
+            const uint32_t n2 = (uint32_t)(p0 >> 32) ^ c3 ^ k1;
+            c1 = (uint32_t)p1;
+            c3 = (uint32_t)p0;
+            c0 = n0;
+            c2 = n2;
+            k0 += PHILOX_W0;
+            k1 += PHILOX_W1;
+        }
+
+        x = c0 >> 1;
+        y = c1 >> 1;
+        hits += ((x * x + y * y) < RADIUS_SQ);
+        x = c2 >> 1;
+        y = c3 >> 1;
+        hits += ((x * x + y * y) < RADIUS_SQ);
+    }
+
+    return hits;
+}
+
+/* Count hits for the points made from counters [first, last), split across
+ * the OpenMP threads in contiguous ranges of whole batches */
+static inline uint64_t countHits(const uint64_t seed, const uint64_t first,
+                                 const uint64_t last) {
+    const int64_t batchCount =
+        (int64_t)((last - first + BATCH_BLOCKS - 1) / BATCH_BLOCKS);
+    uint64_t hits = 0;
+    int64_t batch;
+
+    #pragma omp parallel for schedule(static) reduction(+:hits)
+    for (batch = 0; batch < batchCount; batch++) {
+        const uint64_t start = first + (uint64_t)batch * BATCH_BLOCKS;
+        const uint64_t end =
+            (last - start < BATCH_BLOCKS) ? last : (start + BATCH_BLOCKS);
+        hits += countHitsInBatch(seed, start, (int)(end - start));
+    }
+
+    return hits;
+}
+
+/* pi ~= 4 * hits / samples; each sample is a Bernoulli trial with
+ * p = hits / samples, so the standard error of the estimate is
+ * 4 * sqrt(p * (1 - p) / samples) */
+static inline double estimatePi(const uint64_t hits, const uint64_t samples) {
+    return 4.0 * (double)hits / (double)samples;
+}
+
+static inline double standardError(const uint64_t hits,
+                                   const uint64_t samples) {
+    const double p = (double)hits / (double)samples;
+    return 4.0 * sqrt(p * (1.0 - p) / (double)samples);
+}
+
+#endif
@@ -2,44 +2,54 @@
  * By Oak Ridge National Laboratory
  * Source: https://www.olcf.ornl.gov/tutorials/monte-carlo-pi/
  * Modified by Phil List, 2015
+ *
+ * Usage: pi-openmp [-n samples] [-s seed]
+ * The number of threads is set with OMP_NUM_THREADS.
  */
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <unistd.h>
+#include <inttypes.h>
 #include <omp.h>
-#include <math.h>
-#include <time.h>
- 
-int main(int argc, char* argv[]) {
+#include "pi-monte-carlo.h"
 
-    int niter = 1000000;			// number of iterations per FOR loop
+int main(int argc, char* argv[]) {
 
-    double x = 0, y = 0;			// x,y value for the random coordinate
-    int i = 0;					// loop counter
-    int count = 0;				// Count records the number of how many good coordinates
-    double z = 0;				// Used to check if x^2+y^2<=1
+    uint64_t samples = 100000000;		// total number of random points
+    uint64_t seed = 20150601;			// key of the random number generator
+    uint64_t blocks;				// generator calls (2 points each)
+    uint64_t count;				// number of points inside the circle
     double pi;					// holds approx value of pi
-    int numthreads = 32;
-    omp_set_num_threads(numthreads);
-
- 
-        
-        #pragma omp parallel firstprivate(x, y, z, i) reduction(+:count)
-        {
-            srandom((int)time(NULL) ^ omp_get_thread_num());    //Give random() a seed value
-            for (i=0; i<niter; ++i) {
-                x = (double)random()/RAND_MAX;      //gets a random x coordinate
-                y = (double)random()/RAND_MAX;      //gets a random y coordinate
-                z = sqrt((x*x)+(y*y));          //Checks to see if number is inside unit circle
-                if (z<=1){
-                    ++count;            //if it is, consider it a valid random point
-                }
-            }
+    double start_time, elapsed;
+    int c;
+
+    while ((c = getopt(argc, argv, "n:s:")) != -1) {
+        switch (c) {
+            case 'n':
+                samples = strtoull(optarg, NULL, 10);
+                break;
+            case 's':
+                seed = strtoull(optarg, NULL, 10);
+                break;
+            default:
+                fprintf(stderr, "Usage: %s [-n samples] [-s seed]\n", argv[0]);
+                exit(EXIT_FAILURE);
         }
- 
-        pi = ((double)count/((double)niter * numthreads))*4.0;
-        printf("Pi: %f\n", pi);
- 
+    }
+
+    blocks = (samples + POINTS_PER_BLOCK - 1) / POINTS_PER_BLOCK;
+    samples = blocks * POINTS_PER_BLOCK;
+
+    start_time = omp_get_wtime();
+    count = countHits(seed, 0, blocks);
+    elapsed = omp_get_wtime() - start_time;
+
+    pi = estimatePi(count, samples);
+    printf("Pi: %.12f +/- %.12f\n", pi, standardError(count, samples));
+    printf("%" PRIu64 "\n%" PRIu64 "\n", count, samples);
+    printf("Threads: %d, time: %f s, samples per second: %e\n",
+           omp_get_max_threads(), elapsed, (double)samples / elapsed);
+
     return 0;
 }
-
@@ -1,185 +1,335 @@
 /* HPCU Bi-Weekly Challenge: __CUDACC__ Fire
  * Author: Aaron Weeden, Shodor, April 2015
+ *
+ * Usage: fire-serial [-r rowCount] [-c columnCount] [-t timeStepCount]
+ *                    [-p probabilityOfBurn] [-s seed] [-q]
+ *
+ * Each tree's burn time is one byte, and the forest is surrounded by ghost
+ * trees that never burn, so that every tree has four neighbors and no edge
+ * needs checking.  The "current" and "next" forests are swapped after every
+ * time step rather than copied.  With -q the forest is not displayed, and
+ * only the time taken and the number of trees burned are printed, so that
+ * forests of 100,000 x 100,000 trees (10 GB each) can be burned.
+ *
+ * Whether a tree catches fire is decided by a random number that depends
+ * only on the seed, the time step and the tree, so a seed burns the same
+ * forest however many threads burn it.  Each burning neighbor spreads the
+ * fire with probability p, so a tree with n burning neighbors catches fire
+ * with probability 1 - (1 - p)^n, and one random number decides it.
  */
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
 #include <time.h>
+#include <unistd.h> /* getopt() */
 
-#define FOREST_ROW_COUNT 21
-#define FOREST_COLUMN_COUNT 21
-#define TREE_COUNT (FOREST_ROW_COUNT * FOREST_COLUMN_COUNT)
-#define TIME_STEP_COUNT 100
+#define DEFAULT_ROW_COUNT 21
+#define DEFAULT_COLUMN_COUNT 21
+#define DEFAULT_TIME_STEP_COUNT 100
 #define PROBABILITY_OF_BURN 100 /* Should be between 0 and 100 */
+#define NEIGHBOR_COUNT 4
 #define MAX_BURN_TIME 5
 
+/* Index of the tree in a row and column of a forest with a given number of
+ * columns, past the row of ghost trees above it and the ghost tree to its
+ * left */
+#define TREE_INDEX(rowIdx, colIdx, columnCount) \
+  (((size_t)(rowIdx) + 1) * ((size_t)(columnCount) + 2) + (colIdx) + 1)
+
+/* Number of bytes in a forest, ghost trees included */
+#define FOREST_SIZE(rowCount, columnCount) \
+  (((size_t)(rowCount) + 2) * ((size_t)(columnCount) + 2))
+
 #ifdef __CUDACC__
 __host__ __device__
 #endif
-int isOnFire(const int *forest, const int treeIdx) {
+int isOnFire(const uint8_t *forest, const size_t treeIdx) {
   return forest[treeIdx] > 0;
 }
 
 #ifdef __CUDACC__
 __host__ __device__
 #endif
-int isBurntOut(const int *forest, const int treeIdx) {
+int isBurntOut(const uint8_t *forest, const size_t treeIdx) {
   return forest[treeIdx] >= MAX_BURN_TIME;
 }
 
-void initializeForest(int *currentForest, int *nextForest) {
-  int treeIdx;
+/* A random number from a counter: the seed, the time step and the tree are
+ * mixed with the splitmix64 finalizer, so every thread draws the same number
+ * for the same tree, with no state shared between them */
+#ifdef __CUDACC__
+__host__ __device__
+#endif
+uint64_t randomForTree(const uint64_t seed, const uint64_t timeIdx,
+    const uint64_t treeIdx) {
+  uint64_t x = seed ^ (timeIdx * 0x9e3779b97f4a7c15ULL) ^
+    (treeIdx * 0xd1b54a32d192ed03ULL);
+
+  x ^= x >> 30;
+  x *= 0xbf58476d1ce4e5b9ULL;
+  x ^= x >> 27;
+  x *= 0x94d049bb133111ebULL;
+  x ^= x >> 31;
+  return x;
+}
 
-  /* Start by assuming no trees are burning */
-#pragma omp parallel for
-  for (treeIdx = 0; treeIdx < TREE_COUNT; treeIdx++) {
-    currentForest[treeIdx] = 0;
+/* For each number of burning neighbors, the upper 32 bits of a random
+ * number must be below this for the tree to catch fire: 2^32 times the
+ * probability that at least one of them spreads the fire */
+void initializeCatchThresholds(uint64_t *catchThresholds,
+    const int probabilityOfBurn) {
+  double probabilityOfNoBurn = 1.0;
+  int neighborCount;
+
+  for (neighborCount = 0; neighborCount <= NEIGHBOR_COUNT; neighborCount++) {
+    catchThresholds[neighborCount] =
+      (uint64_t)((1.0 - probabilityOfNoBurn) * 4294967296.0 + 0.5);
+    probabilityOfNoBurn *= (100 - probabilityOfBurn) / 100.0;
   }
+}
 
-  /* Light a random tree on fire */
-  currentForest[random() % TREE_COUNT] = 1;
+void getUserOptions(int argc, char **argv, int *rowCount, int *columnCount,
+    int *timeStepCount, int *probabilityOfBurn, uint64_t *seed,
+    int *isQuiet) {
+  int c;
+
+  while ((c = getopt(argc, argv, "r:c:t:p:s:q")) != -1) {
+    switch(c) {
+      case 'r':
+        (*rowCount) = atoi(optarg);
+        break;
+      case 'c':
+        (*columnCount) = atoi(optarg);
+        break;
+      case 't':
+        (*timeStepCount) = atoi(optarg);
+        break;
+      case 'p':
+        (*probabilityOfBurn) = atoi(optarg);
+        break;
+      case 's':
+        (*seed) = strtoull(optarg, NULL, 0);
+        break;
+      case 'q':
+        (*isQuiet) = 1;
+        break;
+      case '?':
+      default:
+        fprintf(stderr, "Usage: ");
+        fprintf(stderr, "%s [-r rowCount] [-c columnCount] "
+          "[-t timeStepCount] [-p probabilityOfBurn] [-s seed] [-q]\n",
+          argv[0]);
+        exit(EXIT_FAILURE);
+    }
+  }
+  if ((*rowCount) < 1 || (*columnCount) < 1 || (*timeStepCount) < 0) {
+    fprintf(stderr, "%s: the forest needs at least one row and column\n",
+      argv[0]);
+    exit(EXIT_FAILURE);
+  }
+  if ((*probabilityOfBurn) < 0 || (*probabilityOfBurn) > 100) {
+    fprintf(stderr, "%s: the probability of burn is from 0 to 100\n",
+      argv[0]);
+    exit(EXIT_FAILURE);
+  }
+}
+
+void initializeForest(uint8_t *currentForest, uint8_t *nextForest,
+    const int rowCount, const int columnCount) {
+  long rowIdx;
 
-  /* Make a copy of the forest */
+  /* Start by assuming no trees are burning, ghost trees included; each
+   * thread touches the rows it will burn first */
 #pragma omp parallel for
-  for (treeIdx = 0; treeIdx < TREE_COUNT; treeIdx++) {
-    nextForest[treeIdx] = currentForest[treeIdx];
+  for (rowIdx = 0; rowIdx < (long)rowCount + 2; rowIdx++) {
+    memset(currentForest + rowIdx * ((size_t)columnCount + 2), 0,
+      (size_t)columnCount + 2);
+    memset(nextForest + rowIdx * ((size_t)columnCount + 2), 0,
+      (size_t)columnCount + 2);
   }
+
+  /* Light a random tree on fire */
+  currentForest[TREE_INDEX(random() % rowCount, random() % columnCount,
+    columnCount)] = 1;
 }
 
-void displayForest(const int *forest, const int timeIdx) {
+void displayForest(const uint8_t *forest, const int rowCount,
+    const int columnCount, const int timeIdx) {
   int rowIdx;
   int colIdx;
 
   printf("Time step %d\n", timeIdx);
-  for (rowIdx = 0; rowIdx < FOREST_ROW_COUNT; rowIdx++) {
-    for (colIdx = 0; colIdx < FOREST_COLUMN_COUNT; colIdx++) {
-      printf("%d ", forest[rowIdx * FOREST_COLUMN_COUNT + colIdx]);
+  for (rowIdx = 0; rowIdx < rowCount; rowIdx++) {
+    for (colIdx = 0; colIdx < columnCount; colIdx++) {
+      printf("%d ", forest[TREE_INDEX(rowIdx, colIdx, columnCount)]);
     }
     printf("\n");
   }
   printf("\n");
 }
 
-/* Continue to burn trees if they are on fire and haven't burnt out */
+/* Continue to burn trees if they are on fire and haven't burnt out, and
+ * carry every other tree over as it is.  This writes every tree of the next
+ * forest, ghost trees included (which stay 0), so the forests can be
+ * swapped rather than copied. */
 #ifdef __CUDACC__
 __global__
 #endif
-void advanceBurningTrees(const int *currentForest, int *nextForest) {
-  int treeIdx;
+void advanceBurningTrees(const uint8_t *currentForest, uint8_t *nextForest,
+    const size_t forestSize) {
+  long treeIdx;
 
 #ifdef __CUDACC__
-  treeIdx = blockIdx.x;
-  if (treeIdx < TREE_COUNT) {
+  treeIdx = (long)blockIdx.x * blockDim.x + threadIdx.x;
+  if (treeIdx < (long)forestSize) {
 #else
-  #pragma omp parallel for
-  for (treeIdx = 0; treeIdx < TREE_COUNT; treeIdx++) {
+  #pragma omp parallel for simd
+  for (treeIdx = 0; treeIdx < (long)forestSize; treeIdx++) {
 #endif
-    if ((isOnFire(currentForest, treeIdx)) &&
-        (!isBurntOut(currentForest, treeIdx))) {
-      nextForest[treeIdx] = 1 + currentForest[treeIdx];
-    }
+    nextForest[treeIdx] = currentForest[treeIdx] +
+      (isOnFire(currentForest, treeIdx) &&
+       !isBurntOut(currentForest, treeIdx));
   }
 }
 
-/* Given a condition to check, the index of a tree, and the index of a neighbor
- * tree, check if the neighbor tree is on fire (but only if the condition is
- * true), and if it is, randomly spread the fire from that neighbor tree */
-void trySpread(const int treeIdx, const int condition,
-    const int neighborTreeIdx, const int *currentForest, int *nextForest) {
-  if ((condition) &&
-      (isOnFire(currentForest, neighborTreeIdx)) &&
-      ((random() % 100) < PROBABILITY_OF_BURN)) {
-    nextForest[treeIdx] = 1;
+/* Must come after advanceBurningTrees(), which it overwrites for the trees
+ * it catches on fire */
+void burnNewTrees(const uint8_t *currentForest, uint8_t *nextForest,
+    const int rowCount, const int columnCount, const uint64_t *catchThresholds,
+    const uint64_t seed, const int timeIdx) {
+  const size_t rowStride = (size_t)columnCount + 2;
+  long rowIdx;
+  int colIdx;
+
+  /* Find trees that are not on fire yet and try to catch them on fire from
+   * burning neighbor trees; the ghost trees around the forest are never on
+   * fire, so every tree can count all four of its neighbors.  A tree not on
+   * fire has 0 in the next forest, so or-ing in whether it caught fire
+   * leaves the other trees as advanceBurningTrees() left them. */
+#pragma omp parallel for private(colIdx)
+  for (rowIdx = 0; rowIdx < rowCount; rowIdx++) {
+    const size_t rowStart = TREE_INDEX(rowIdx, 0, columnCount);
+
+#pragma omp simd
+    for (colIdx = 0; colIdx < columnCount; colIdx++) {
+      const size_t treeIdx = rowStart + colIdx;
+      const int burningNeighborCount =
+        isOnFire(currentForest, treeIdx - rowStride) + /* Top neighbor */
+        isOnFire(currentForest, treeIdx - 1) +         /* Left neighbor */
+        isOnFire(currentForest, treeIdx + rowStride) + /* Bottom neighbor */
+        isOnFire(currentForest, treeIdx + 1);          /* Right neighbor */
+      const int catchesFire =
+        (randomForTree(seed, timeIdx, treeIdx) >> 32) <
+        catchThresholds[burningNeighborCount];
+
+      nextForest[treeIdx] |=
+        (!isOnFire(currentForest, treeIdx)) & catchesFire;
+    }
   }
 }
 
-void burnNewTrees(const int *currentForest, int *nextForest) {
-  int treeIdx;
+/* Count the trees that have caught fire */
+size_t countBurnedTrees(const uint8_t *forest, const size_t forestSize) {
+  size_t burnedCount = 0;
+  long treeIdx;
 
-  /* Find trees that are not on fire yet and try to catch them on fire from
-   * burning neighbor trees */
-#pragma omp parallel for
-  for (treeIdx = 0; treeIdx < TREE_COUNT; treeIdx++) {
-    if (!isOnFire(currentForest, treeIdx)) {
-
-      /* Top neighbor */
-      trySpread(treeIdx,
-        treeIdx >= FOREST_COLUMN_COUNT,
-        treeIdx - FOREST_COLUMN_COUNT,
-        currentForest, &(*nextForest));
-
-      /* Left neighbor */
-      trySpread(treeIdx,
-        (treeIdx % FOREST_COLUMN_COUNT) > 0,
-        treeIdx - 1,
-        currentForest, &(*nextForest));
-
-      /* Bottom neighbor */
-      trySpread(treeIdx,
-        treeIdx < (TREE_COUNT - FOREST_COLUMN_COUNT),
-        treeIdx + FOREST_COLUMN_COUNT,
-        currentForest, &(*nextForest));
-
-      /* Right neighbor */
-      trySpread(treeIdx,
-        (treeIdx % FOREST_COLUMN_COUNT) < (FOREST_COLUMN_COUNT - 1),
-        treeIdx + 1,
-        currentForest, &(*nextForest));
-    }
+#pragma omp parallel for simd reduction(+:burnedCount)
+  for (treeIdx = 0; treeIdx < (long)forestSize; treeIdx++) {
+    burnedCount += isOnFire(forest, treeIdx);
   }
+
+  return burnedCount;
 }
 
-int main() {
+int main(int argc, char **argv) {
   /* Keep track of how many time steps each tree in the forest has been
    * burning. We need a "current" and "next" so that we don't overwrite the state
    * of one tree while we are checking the state of another tree. */
-  int *currentForest;
-  int *nextForest;
+  uint8_t *currentForest;
+  uint8_t *nextForest;
+  uint8_t *swapForest;
 #ifdef __CUDACC__
-  int *dev_currentForest;
-  int *dev_nextForest;
+  uint8_t *dev_currentForest;
+  uint8_t *dev_nextForest;
 #endif
 
+  int rowCount = DEFAULT_ROW_COUNT;
+  int columnCount = DEFAULT_COLUMN_COUNT;
+  int timeStepCount = DEFAULT_TIME_STEP_COUNT;
+  int probabilityOfBurn = PROBABILITY_OF_BURN;
+  uint64_t seed = time(NULL);
+  uint64_t catchThresholds[NEIGHBOR_COUNT + 1];
+  int isQuiet = 0;
+  size_t forestSize;
   int timeIdx;
-  int treeIdx;
-
-  /* Seed the random number generator with the current time */
-  srandom(time(NULL));
-
-  /* Allocate memory */
-  currentForest = (int*)malloc(TREE_COUNT * sizeof(int));
-  nextForest = (int*)malloc(TREE_COUNT * sizeof(int));
+  struct timespec startTime, endTime;
+  double runTime;
+
+  getUserOptions(argc, argv, &rowCount, &columnCount, &timeStepCount,
+    &probabilityOfBurn, &seed, &isQuiet);
+  forestSize = FOREST_SIZE(rowCount, columnCount);
+  initializeCatchThresholds(catchThresholds, probabilityOfBurn);
+
+  /* Seed the random number generator that picks the first tree to light
+   * with the seed, the current time unless one is given */
+  srandom(seed);
+
+  /* Allocate memory, once for the whole run */
+  currentForest = (uint8_t*)malloc(forestSize);
+  nextForest = (uint8_t*)malloc(forestSize);
+  if (currentForest == NULL || nextForest == NULL) {
+    fprintf(stderr, "%s: could not allocate two forests of %zu bytes\n",
+      argv[0], forestSize);
+    exit(EXIT_FAILURE);
+  }
 #ifdef __CUDACC__
-  cudaMalloc((void**)&dev_currentForest, TREE_COUNT * sizeof(int));
-  cudaMalloc((void**)&dev_nextForest, TREE_COUNT * sizeof(int));
+  cudaMalloc((void**)&dev_currentForest, forestSize);
+  cudaMalloc((void**)&dev_nextForest, forestSize);
 #endif
 
-  initializeForest(&(*currentForest), &(*nextForest));
+  initializeForest(currentForest, nextForest, rowCount, columnCount);
 
-  for (timeIdx = 1; timeIdx <= TIME_STEP_COUNT; timeIdx++) {
-    /* These three steps can happen in any order; they are independent of each
-     * other */
-    displayForest(currentForest, timeIdx);
+  clock_gettime(CLOCK_MONOTONIC, &startTime);
+  for (timeIdx = 1; timeIdx <= timeStepCount; timeIdx++) {
+    if (!isQuiet) {
+      displayForest(currentForest, rowCount, columnCount, timeIdx);
+    }
 
+    /* The burning trees advance first, then the new trees catch fire */
 #ifdef __CUDACC__
-    cudaMemcpy(dev_currentForest, currentForest, TREE_COUNT * sizeof(int),
-      cudaMemcpyHostToDevice);
-    cudaMemcpy(dev_nextForest, nextForest, TREE_COUNT * sizeof(int),
+    cudaMemcpy(dev_currentForest, currentForest, forestSize,
       cudaMemcpyHostToDevice);
 
-    advanceBurningTrees<<<TREE_COUNT, 1>>>(dev_currentForest, dev_nextForest);
+    advanceBurningTrees<<<(forestSize + 255) / 256, 256>>>(dev_currentForest,
+      dev_nextForest, forestSize);
 
-    cudaMemcpy(nextForest, dev_nextForest, TREE_COUNT * sizeof(int),
+    cudaMemcpy(nextForest, dev_nextForest, forestSize,
       cudaMemcpyDeviceToHost);
 #else
-    advanceBurningTrees(currentForest, &(*nextForest));
+    advanceBurningTrees(currentForest, nextForest, forestSize);
 #endif
 
-    burnNewTrees(currentForest, &(*nextForest));
+    burnNewTrees(currentForest, nextForest, rowCount, columnCount,
+      catchThresholds, seed, timeIdx);
 
-    for (treeIdx = 0; treeIdx < TREE_COUNT; treeIdx++) {
-      currentForest[treeIdx] = nextForest[treeIdx];
-    }
+    /* The next forest becomes the current one, and the current one is
+     * overwritten next time step */
+    swapForest = currentForest;
+    currentForest = nextForest;
+    nextForest = swapForest;
+  }
+  clock_gettime(CLOCK_MONOTONIC, &endTime);
+  runTime = (endTime.tv_sec - startTime.tv_sec) +
+    (endTime.tv_nsec - startTime.tv_nsec) * 1e-9;
+
+  if (isQuiet) {
+    printf("%d x %d trees, %d time steps in %f seconds (%e trees per "
+      "second)\n", rowCount, columnCount, timeStepCount, runTime,
+      (double)rowCount * columnCount * timeStepCount / runTime);
+    printf("Trees burned: %zu (seed %llu)\n", countBurnedTrees(currentForest,
+      forestSize), (unsigned long long)seed);
   }
 
   /* Free memory */
@@ -0,0 +1,251 @@
+/**
+ * HPCU Bi-Weekly Challenge: Distributed Ideal Gas
+ * MPI version
+ * Config - defines functions for choosing the size and layout of the flasks
+ * and particles on the command line.
+ *
+ * @author Aaron Weeden, Shodor Education Foundation
+ * @version 3.1
+ * @since 3.1
+ */
+#include <mpi.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include "constants.h"
+#include "config.h"
+
+/**
+ * If a condition fails, print a message and the usage on rank 0, and exit on
+ * every process.
+ *
+ * @param condition the condition that must hold
+ * @param message the message describing the condition
+ * @param programName the name of the program
+ */
+static void require(const bool condition, const char *message,
+    const char *programName) {
+
+  int rank;
+
+  if (condition) {
+    return;
+  }
+
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  if (rank == 0) {
+    fprintf(stderr, "%s\n", message);
+    fprintf(stderr, "Usage: %s [-1 RxC:S] [-2 RxC:S] [-b RxC+T+L] [-f D] "
+      "[-t N] [-r SEED] [-m N] [-z] [-o FILE] [-e TOL] [-w N] [-d] "
+      "[-p FILE] [-s N] [-x]\n", programName);
+  }
+  MPI_Finalize();
+  exit(EXIT_FAILURE);
+
+}
+
+/**
+ * Parse a flask's dimensions and stopcock row, in the form RxC:S.
+ *
+ * @param text the text to parse
+ * @param rowCount_p pointer to the number of rows
+ * @param columnCount_p pointer to the number of columns
+ * @param stopcockRow_p pointer to the stopcock row
+ * @return true if the text is in the right form
+ */
+static bool parseFlask(const char *text, int *rowCount_p, int *columnCount_p,
+    int *stopcockRow_p) {
+
+  int length = 0;
+
+  return sscanf(text, "%dx%d:%d%n", rowCount_p, columnCount_p,
+    stopcockRow_p, &length) == 3 && text[length] == '\0';
+
+}
+
+/**
+ * Set a config to the defaults in constants.h, then apply the command-line
+ * options.  Every process must call this with the same options; if they are
+ * invalid, rank 0 prints the usage and every process exits.
+ *
+ * @param config_p pointer to the config to fill in
+ * @param argc number of command-line arguments
+ * @param argv array of command-line arguments
+ * @param defaultSeed the seed to use if none is given
+ */
+void initializeConfig(config_type *config_p, int argc, char **argv,
+    const unsigned int defaultSeed) {
+
+  int option, length;
+
+  config_p->flask1RowCount = DEFAULT_FLASK_1_ROW_COUNT;
+  config_p->flask1ColumnCount = DEFAULT_FLASK_1_COLUMN_COUNT;
+  config_p->flask1StopcockRow = DEFAULT_FLASK_1_STOPCOCK_ROW;
+  config_p->flask2RowCount = DEFAULT_FLASK_2_ROW_COUNT;
+  config_p->flask2ColumnCount = DEFAULT_FLASK_2_COLUMN_COUNT;
+  config_p->flask2StopcockRow = DEFAULT_FLASK_2_STOPCOCK_ROW;
+  config_p->blockRowCount = DEFAULT_PARTICLE_BLOCK_ROW_COUNT;
+  config_p->blockColumnCount = DEFAULT_PARTICLE_BLOCK_COLUMN_COUNT;
+  config_p->blockTopRow = DEFAULT_PARTICLE_BLOCK_TOP_ROW;
+  config_p->blockLeftColumn = DEFAULT_PARTICLE_BLOCK_LEFT_COLUMN;
+  config_p->fillDensity = 0.0;
+  config_p->seed = defaultSeed;
+  config_p->timeCount = DEFAULT_TIME_COUNT;
+  config_p->sortInterval = DEFAULT_SORT_INTERVAL;
+  config_p->isMortonOrder = false;
+  config_p->statisticsPath = NULL;
+  config_p->tolerance = 0.0;
+  config_p->windowCount = DEFAULT_WINDOW_COUNT;
+  config_p->isDistributed = false;
+  config_p->snapshotPath = NULL;
+  config_p->snapshotInterval = DEFAULT_SNAPSHOT_INTERVAL;
+  config_p->isBinarySnapshot = false;
+
+  while ((option = getopt(argc, argv, "1:2:b:f:t:r:m:zo:e:w:dp:s:x")) != -1) {
+    length = 0;
+    switch (option) {
+      case '1':
+        require(parseFlask(optarg, &(config_p->flask1RowCount),
+            &(config_p->flask1ColumnCount), &(config_p->flask1StopcockRow)),
+          "Flask 1 must be given as ROWSxCOLUMNS:STOPCOCK_ROW", argv[0]);
+        break;
+      case '2':
+        require(parseFlask(optarg, &(config_p->flask2RowCount),
+            &(config_p->flask2ColumnCount), &(config_p->flask2StopcockRow)),
+          "Flask 2 must be given as ROWSxCOLUMNS:STOPCOCK_ROW", argv[0]);
+        break;
+      case 'b':
+        require(sscanf(optarg, "%dx%d+%d+%d%n", &(config_p->blockRowCount),
+            &(config_p->blockColumnCount), &(config_p->blockTopRow),
+            &(config_p->blockLeftColumn), &length) == 4 &&
+          optarg[length] == '\0',
+          "The particle block must be given as ROWSxCOLUMNS+TOP+LEFT",
+          argv[0]);
+        break;
+      case 'f':
+        require(sscanf(optarg, "%lf%n", &(config_p->fillDensity), &length) ==
+          1 && optarg[length] == '\0', "The density must be a number",
+          argv[0]);
+        break;
+      case 't':
+        require(sscanf(optarg, "%d%n", &(config_p->timeCount), &length) == 1
+          && optarg[length] == '\0', "The time steps must be an integer",
+          argv[0]);
+        break;
+      case 'r':
+        require(sscanf(optarg, "%u%n", &(config_p->seed), &length) == 1 &&
+          optarg[length] == '\0', "The seed must be an unsigned integer",
+          argv[0]);
+        break;
+      case 'm':
+        require(sscanf(optarg, "%d%n", &(config_p->sortInterval), &length) ==
+          1 && optarg[length] == '\0', "The sort interval must be an integer",
+          argv[0]);
+        break;
+      case 'z':
+        config_p->isMortonOrder = true;
+        break;
+      case 'o':
+        config_p->statisticsPath = optarg;
+        break;
+      case 'e':
+        require(sscanf(optarg, "%lf%n", &(config_p->tolerance), &length) ==
+          1 && optarg[length] == '\0', "The tolerance must be a number",
+          argv[0]);
+        break;
+      case 'w':
+        require(sscanf(optarg, "%d%n", &(config_p->windowCount), &length) ==
+          1 && optarg[length] == '\0', "The window must be an integer",
+          argv[0]);
+        break;
+      case 'd':
+        config_p->isDistributed = true;
+        break;
+      case 'p':
+        config_p->snapshotPath = optarg;
+        break;
+      case 's':
+        require(sscanf(optarg, "%d%n", &(config_p->snapshotInterval),
+            &length) == 1 && optarg[length] == '\0',
+          "The snapshot interval must be an integer", argv[0]);
+        break;
+      case 'x':
+        config_p->isBinarySnapshot = true;
+        break;
+      default:
+        require(false, "Unknown option", argv[0]);
+    }
+  }
+
+  require(config_p->flask1RowCount > 0 && config_p->flask1ColumnCount > 0 &&
+    config_p->flask2RowCount > 0 && config_p->flask2ColumnCount > 0,
+    "Flasks must have at least one row and column", argv[0]);
+  require((long)config_p->flask1RowCount * config_p->flask1ColumnCount <=
+    MAX_FLASK_CELL_COUNT &&
+    (long)config_p->flask2RowCount * config_p->flask2ColumnCount <=
+    MAX_FLASK_CELL_COUNT, "Flasks can have at most 2^31-1 cells", argv[0]);
+  require(config_p->flask1StopcockRow >= 0 &&
+    config_p->flask1StopcockRow < config_p->flask1RowCount &&
+    config_p->flask1StopcockRow < config_p->flask2RowCount &&
+    config_p->flask2StopcockRow >= 0 &&
+    config_p->flask2StopcockRow < config_p->flask1RowCount &&
+    config_p->flask2StopcockRow < config_p->flask2RowCount,
+    "Stopcocks must be in rows that both flasks have", argv[0]);
+  /* -f fills flask 1 at random instead of the block, so the block is only
+   * checked without it */
+  require(config_p->fillDensity > 0.0 ||
+    (config_p->blockRowCount >= 0 && config_p->blockColumnCount >= 0 &&
+    config_p->blockTopRow >= 0 && config_p->blockLeftColumn >= 0 &&
+    config_p->blockTopRow + config_p->blockRowCount <=
+    config_p->flask1RowCount &&
+    config_p->blockLeftColumn + config_p->blockColumnCount <=
+    config_p->flask1ColumnCount), "The particle block must fit in flask 1",
+    argv[0]);
+  require(config_p->fillDensity >= 0.0 && config_p->fillDensity <= 1.0,
+    "The density must be between 0 and 1", argv[0]);
+  require(config_p->timeCount >= 0, "The time steps must not be negative",
+    argv[0]);
+  require(config_p->sortInterval >= 0,
+    "The sort interval must not be negative", argv[0]);
+  require(config_p->tolerance >= 0.0, "The tolerance must not be negative",
+    argv[0]);
+  require(config_p->windowCount > 0, "The window must be positive", argv[0]);
+  require(config_p->snapshotInterval > 0,
+    "The snapshot interval must be positive", argv[0]);
+
+}
+
+/**
+ * Print a config.
+ *
+ * @param config the config
+ * @param processCount the number of processes
+ */
+void printConfig(const config_type config, const int processCount) {
+
+  printf("Flask 1 = %dx%d, stopcock row %d\n", config.flask1RowCount,
+    config.flask1ColumnCount, config.flask1StopcockRow);
+  printf("Flask 2 = %dx%d, stopcock row %d\n", config.flask2RowCount,
+    config.flask2ColumnCount, config.flask2StopcockRow);
+  if (config.fillDensity > 0.0) {
+    printf("Particles = random, density %f\n", config.fillDensity);
+  }
+  else {
+    printf("Particles = %dx%d block at row %d, column %d\n",
+      config.blockRowCount, config.blockColumnCount, config.blockTopRow,
+      config.blockLeftColumn);
+  }
+  printf("Time steps = %d, seed = %u\n", config.timeCount, config.seed);
+  if (config.tolerance > 0.0) {
+    printf("Equilibrium = mean ratio over %d time steps within %g of 1\n",
+      config.windowCount, config.tolerance);
+  }
+  if (config.snapshotPath != NULL) {
+    printf("Snapshots = %s every %d time steps to %s\n",
+      config.isBinarySnapshot ? "bitmaps" : "pictures",
+      config.snapshotInterval, config.snapshotPath);
+  }
+  printf("Processes = %d, %s\n", processCount, config.isDistributed ?
+    "one decomposed simulation" : "one simulation each");
+
+}
@@ -0,0 +1,62 @@
+/**
+ * HPCU Bi-Weekly Challenge: Distributed Ideal Gas
+ * MPI version
+ * Config - defines functions for choosing the size and layout of the flasks
+ * and particles on the command line.
+ *
+ * Options:
+ *   -1 RxC:S    flask 1 has R rows and C columns, with its stopcock in row S
+ *   -2 RxC:S    flask 2 has R rows and C columns, with its stopcock in row S
+ *   -b RxC+T+L  the particles start in a block of R rows and C columns of
+ *               flask 1, whose top-left cell is in row T and column L
+ *   -f D        instead, each cell of flask 1 starts with a particle with
+ *               probability D
+ *   -t N        run for N time steps
+ *   -r SEED     seed the random number generators with SEED
+ *   -m N        sort the particles by cell every N time steps, or never if N
+ *               is 0
+ *   -z          sort the particles in Morton (Z) order instead of row-major
+ *               order
+ *   -o FILE     write the particle counts and ratio after every time step to
+ *               FILE (without -d, those of rank 0's simulation)
+ *   -e TOL      stop once the mean ratio over a window of time steps is
+ *               within TOL of 1
+ *   -w N        average the ratio over N time steps for -e
+ *   -d          run one simulation decomposed across the processes
+ *   -p FILE     write a picture of the flasks to FILE every few time steps
+ *               and at the end (without -d, of rank 0's simulation)
+ *   -s N        write the pictures every N time steps
+ *   -x          write the pictures as binary occupancy bitmaps instead of
+ *               ASCII; see snapshot.h
+ *
+ * @author Aaron Weeden, Shodor Education Foundation
+ * @version 3.1
+ * @since 3.1
+ */
+#ifndef CONFIG_H
+#define CONFIG_H
+
+#include "typedefs.h"
+
+/**
+ * Set a config to the defaults in constants.h, then apply the command-line
+ * options.  Every process must call this with the same options; if they are
+ * invalid, rank 0 prints the usage and every process exits.
+ *
+ * @param config_p pointer to the config to fill in
+ * @param argc number of command-line arguments
+ * @param argv array of command-line arguments
+ * @param defaultSeed the seed to use if none is given
+ */
+void initializeConfig(config_type *config_p, int argc, char **argv,
+    const unsigned int defaultSeed);
+
+/**
+ * Print a config.
+ *
+ * @param config the config
+ * @param processCount the number of processes
+ */
+void printConfig(const config_type config, const int processCount);
+
+#endif
@@ -18,6 +18,21 @@
  */
 #define EMPTY -1
 
+/**
+ * Marks the border cells surrounding each flask, which particles can never
+ * move into.  Must be < 0 and != EMPTY.
+ */
+#define WALL -2
+
+/**
+ * Alignment in bytes of the flask cells, a cache line.
+ */
+#define CELL_ALIGNMENT 64
+
+/* Particle flags */
+#define PARTICLE_IN_FLASK_2 1u
+#define PARTICLE_IN_STOPCOCK 2u
+
 /* Directions */
 #define UP 0
 #define LEFT 1
@@ -26,33 +41,97 @@
 #define INTO_FLASK_1_STOPCOCK 4
 #define INTO_FLASK_2_STOPCOCK 5
 
+/* Phases of a time step.  Particles away from the stopcocks are coloured
+ * (row + 2 * column) % COLOR_COUNT, which gives different colours to any two
+ * cells within 2 steps of each other, so particles of the same colour never
+ * compete for a cell and can move in parallel.  Particles in or next to a
+ * stopcock move one at a time in a phase of their own.  The PHASE_COUNT
+ * phases run in a new random order every time step.
+ */
+#define COLOR_COUNT 5
+#define STOPCOCK_PHASE COLOR_COUNT
+#define PHASE_COUNT (COLOR_COUNT + 1)
+
+/**
+ * Phase of a particle that has already moved into this process's block from
+ * a neighboring block during the current time step.
+ */
+#define ARRIVED_PHASE PHASE_COUNT
+
+/**
+ * Maximum number of particles that can be in or next to the stopcocks: one in
+ * each stopcock and one on each side of each stopcock.
+ */
+#define MAX_STOPCOCK_PARTICLES 6
+
 /**
  * Tag used for MPI calls.
  */
 #define TAG 0
 
+/**
+ * Number of ints describing a particle that moves between processes: its ID,
+ * its flask's ID, its row and its column.
+ */
+#define PARTICLE_MESSAGE_SIZE 4
+
 /* Flasks are defined as a 2D array; they have a certain number of rows and
  * columns defined below.  The stopcock for each flask is located at a certain
- * row in the flask, also defined below.
+ * row in the flask, also defined below.  These are the defaults, which can be
+ * changed on the command line (see config.h).
  */
-static const int FLASK_1_ROW_COUNT = 24;
-static const int FLASK_1_COLUMN_COUNT = 27;
-static const int FLASK_1_STOPCOCK_ROW = 13;
-static const int FLASK_2_ROW_COUNT = 69;
-static const int FLASK_2_COLUMN_COUNT = 52;
-static const int FLASK_2_STOPCOCK_ROW = 14;
+static const int DEFAULT_FLASK_1_ROW_COUNT = 24;
+static const int DEFAULT_FLASK_1_COLUMN_COUNT = 27;
+static const int DEFAULT_FLASK_1_STOPCOCK_ROW = 13;
+static const int DEFAULT_FLASK_2_ROW_COUNT = 69;
+static const int DEFAULT_FLASK_2_COLUMN_COUNT = 52;
+static const int DEFAULT_FLASK_2_STOPCOCK_ROW = 14;
 
-/* Particles are located in a contiguous block in flask 1.  The dimensions and
- * location of that block are defined below.
+/* By default, particles are located in a contiguous block in flask 1.  The
+ * dimensions and location of that block are defined below.
+ */
+static const int DEFAULT_PARTICLE_BLOCK_ROW_COUNT = 10;
+static const int DEFAULT_PARTICLE_BLOCK_COLUMN_COUNT = 12;
+static const int DEFAULT_PARTICLE_BLOCK_TOP_ROW = 7;
+static const int DEFAULT_PARTICLE_BLOCK_LEFT_COLUMN = 8;
+
+/**
+ * By default, the simulation should run for this many time steps.
+ */
+static const int DEFAULT_TIME_COUNT = 1000;
+
+/**
+ * By default, the ratio is averaged over this many time steps to decide
+ * whether the flasks are at equilibrium.
+ */
+static const int DEFAULT_WINDOW_COUNT = 100;
+
+/**
+ * By default, the particles are sorted by cell every this many time steps.
+ */
+static const int DEFAULT_SORT_INTERVAL = 100;
+
+/**
+ * By default, a picture of the flasks is written every this many time steps.
+ */
+static const int DEFAULT_SNAPSHOT_INTERVAL = 100;
+
+/**
+ * Number of bytes reserved in front of each picture for its header, which
+ * holds the time step.
+ */
+#define SNAPSHOT_HEADER_CAPACITY 32
+
+/**
+ * First bytes of a file of binary pictures.
  */
-static const int PARTICLE_BLOCK_ROW_COUNT = 10;
-static const int PARTICLE_BLOCK_COLUMN_COUNT = 12;
-static const int PARTICLE_BLOCK_TOP_ROW = 7;
-static const int PARTICLE_BLOCK_LEFT_COLUMN = 8;
+#define SNAPSHOT_MAGIC "IGAS"
 
 /**
- * The simulation should run for this many time steps.
+ * Largest number of cells in a flask.  Cells are indexed with 64-bit
+ * integers, but particle IDs, which are at most the number of cells, are
+ * ints.
  */
-static const int TIME_COUNT = 1000;
+#define MAX_FLASK_CELL_COUNT 2147483647L
 
 #endif
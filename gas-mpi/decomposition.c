@@ -0,0 +1,317 @@
+/**
+ * HPCU Bi-Weekly Challenge: Distributed Ideal Gas
+ * MPI version
+ * Decomposition - defines functions for splitting one large simulation into
+ * blocks of rows, one per process, and for exchanging the cells and particles
+ * on the edges of those blocks.
+ *
+ * @author Aaron Weeden, Shodor Education Foundation
+ * @version 3.1
+ * @since 3.1
+ */
+#include <mpi.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "constants.h"
+#include "memory-management.h"
+#include "decomposition.h"
+
+/**
+ * Return the first row of a process's block.  Blocks are even in size except
+ * that a boundary falling between the stopcock rows moves up to the first of
+ * them.
+ *
+ * @param rank the rank of the process, or the number of processes for the
+ *   row after the last block
+ * @param size the number of processes
+ * @param rowCount the number of rows in the taller flask
+ * @param firstStopcockRow the first of the stopcock rows
+ * @param lastStopcockRow the last of the stopcock rows
+ * @return the first row of the block
+ */
+static int calculateFirstRow(const int rank, const int size,
+    const int rowCount, const int firstStopcockRow,
+    const int lastStopcockRow) {
+
+  const int rowIdx = (int)((long)rank * rowCount / size);
+
+  return (rowIdx > firstStopcockRow && rowIdx <= lastStopcockRow) ?
+    firstStopcockRow : rowIdx;
+
+}
+
+/**
+ * Split the rows of the flasks evenly across the processes, keeping both
+ * stopcock rows in the same block so that every move through a stopcock
+ * happens within one process, and allocate the message buffers.  Exits if
+ * some process would get no rows.
+ *
+ * @param domain_p pointer to the domain to initialize
+ * @param rowCount the number of rows in the taller flask
+ * @param stopcockRow1 the row of the first flask's stopcock
+ * @param stopcockRow2 the row of the second flask's stopcock
+ * @param columnCount the number of columns in both flasks together
+ */
+void initializeDomain(domain_type *domain_p, const int rowCount,
+    const int stopcockRow1, const int stopcockRow2, const int columnCount) {
+
+  const int firstStopcockRow =
+    (stopcockRow1 < stopcockRow2) ? stopcockRow1 : stopcockRow2;
+  const int lastStopcockRow =
+    (stopcockRow1 < stopcockRow2) ? stopcockRow2 : stopcockRow1;
+  int size, rank;
+
+  MPI_Comm_rank(MPI_COMM_WORLD, &(domain_p->rank));
+  MPI_Comm_size(MPI_COMM_WORLD, &size);
+
+  /* Every process checks every block, so they all exit together */
+  for (rank = 0; rank < size; rank++) {
+    if (calculateFirstRow(rank + 1, size, rowCount, firstStopcockRow,
+          lastStopcockRow) <= calculateFirstRow(rank, size, rowCount,
+            firstStopcockRow, lastStopcockRow)) {
+      if (domain_p->rank == 0) {
+        fprintf(stderr, "Too many processes for %d rows, exiting!\n",
+          rowCount);
+      }
+      MPI_Finalize();
+      exit(EXIT_FAILURE);
+    }
+  }
+
+  domain_p->firstRowIdx = calculateFirstRow(domain_p->rank, size, rowCount,
+    firstStopcockRow, lastStopcockRow);
+  domain_p->endRowIdx = calculateFirstRow(domain_p->rank + 1, size, rowCount,
+    firstStopcockRow, lastStopcockRow);
+  domain_p->upRank = (domain_p->rank > 0) ?
+    (domain_p->rank - 1) : MPI_PROC_NULL;
+  domain_p->downRank = (domain_p->rank < size - 1) ?
+    (domain_p->rank + 1) : MPI_PROC_NULL;
+
+  /* Only particles in the first or last row of a block can leave it, and
+   * each particle moves once per time step */
+  domain_p->bufferCapacity = columnCount;
+  domain_p->migrantIdxs = (int*)malloc(2 * columnCount * sizeof(int));
+  domain_p->sendUpBuffer = (int*)malloc(PARTICLE_MESSAGE_SIZE * columnCount *
+    sizeof(int));
+  domain_p->sendDownBuffer = (int*)malloc(PARTICLE_MESSAGE_SIZE *
+    columnCount * sizeof(int));
+  domain_p->receiveBuffer = (int*)malloc(PARTICLE_MESSAGE_SIZE * columnCount *
+    sizeof(int));
+  if (domain_p->migrantIdxs == NULL || domain_p->sendUpBuffer == NULL ||
+      domain_p->sendDownBuffer == NULL || domain_p->receiveBuffer == NULL) {
+    fprintf(stderr, "Could not allocate message buffers, exiting!\n");
+    exit(EXIT_FAILURE);
+  }
+  domain_p->migrantCount = 0;
+  domain_p->sentCount = 0;
+
+}
+
+/**
+ * Note that a particle has just moved, and if it moved out of this process's
+ * block, add it to the particles to send to the neighboring process.  Can be
+ * called by several OpenMP threads at once.
+ *
+ * @param domain_p pointer to the domain
+ * @param particleList_p pointer to the list of particles
+ * @param particleIdx index in the list of the particle that moved
+ */
+void recordMove(domain_type *domain_p, particle_list_type *particleList_p,
+    const int particleIdx) {
+
+  const int rowIdx = particleList_p->elements[particleIdx].rowIdx;
+  int slot;
+
+  if (rowIdx < domain_p->firstRowIdx || rowIdx >= domain_p->endRowIdx) {
+#pragma omp atomic capture
+    slot = domain_p->migrantCount++;
+    domain_p->migrantIdxs[slot] = particleIdx;
+  }
+
+}
+
+/**
+ * Add the particles in a message to the flasks and the particle list.  They
+ * do not move again during the current time step.
+ *
+ * @param buffer the message
+ * @param count the number of ints in the message
+ * @param particleList_p pointer to the list of particles
+ * @param flask1_p pointer to the first flask
+ * @param flask2_p pointer to the second flask
+ */
+static void receiveParticles(const int *buffer, const int count,
+    particle_list_type *particleList_p, flask_type *flask1_p,
+    flask_type *flask2_p) {
+
+  particle_type *particle_p;
+  flask_type *flask_p;
+  int i;
+
+  growParticles(particleList_p,
+    particleList_p->count + count / PARTICLE_MESSAGE_SIZE);
+
+  for (i = 0; i < count; i += PARTICLE_MESSAGE_SIZE) {
+    particle_p = &(particleList_p->elements[particleList_p->count]);
+    flask_p = (1 == buffer[i+1]) ? flask1_p : flask2_p;
+    particle_p->id = buffer[i];
+    particle_p->rowIdx = buffer[i+2];
+    particle_p->columnIdx = buffer[i+3];
+    particle_p->flags = (1 == buffer[i+1]) ? 0u : PARTICLE_IN_FLASK_2;
+    FLASK_CELL(*flask_p, particle_p->rowIdx, particle_p->columnIdx) =
+      particle_p->id;
+    flask_p->particleCount++;
+    particleList_p->phases[particleList_p->count] = ARRIVED_PHASE;
+    particleList_p->count++;
+  }
+
+}
+
+/**
+ * Send the particles that have left this process's block since the last call
+ * to the processes that now own them, add the particles arriving from the
+ * neighboring processes to the flasks and the particle list, and then
+ * exchange the rows on the edges of the blocks.
+ *
+ * @param domain_p pointer to the domain
+ * @param particleList_p pointer to the list of particles
+ * @param flask1_p pointer to the first flask
+ * @param flask2_p pointer to the second flask
+ */
+void exchangeMigrants(domain_type *domain_p,
+    particle_list_type *particleList_p, flask_type *flask1_p,
+    flask_type *flask2_p) {
+
+  const int bufferSize = PARTICLE_MESSAGE_SIZE * domain_p->bufferCapacity;
+  particle_type *particle_p;
+  int *buffer;
+  int sendUpCount = 0, sendDownCount = 0, receiveCount, i;
+  MPI_Status status;
+
+  for (i = domain_p->sentCount; i < domain_p->migrantCount; i++) {
+    particle_p = &(particleList_p->elements[domain_p->migrantIdxs[i]]);
+    if (particle_p->rowIdx < domain_p->firstRowIdx) {
+      buffer = &(domain_p->sendUpBuffer[sendUpCount]);
+      sendUpCount += PARTICLE_MESSAGE_SIZE;
+    }
+    else {
+      buffer = &(domain_p->sendDownBuffer[sendDownCount]);
+      sendDownCount += PARTICLE_MESSAGE_SIZE;
+    }
+    PARTICLE_FLASK(*particle_p, flask1_p, flask2_p)->particleCount--;
+    buffer[0] = particle_p->id;
+    buffer[1] = PARTICLE_FLASK_ID(*particle_p);
+    buffer[2] = particle_p->rowIdx;
+    buffer[3] = particle_p->columnIdx;
+  }
+  domain_p->sentCount = domain_p->migrantCount;
+
+  MPI_Sendrecv(domain_p->sendUpBuffer, sendUpCount, MPI_INT, domain_p->upRank,
+    TAG, domain_p->receiveBuffer, bufferSize, MPI_INT, domain_p->downRank,
+    TAG, MPI_COMM_WORLD, &status);
+  MPI_Get_count(&status, MPI_INT, &receiveCount);
+  receiveParticles(domain_p->receiveBuffer, receiveCount, particleList_p,
+    flask1_p, flask2_p);
+
+  MPI_Sendrecv(domain_p->sendDownBuffer, sendDownCount, MPI_INT,
+    domain_p->downRank, TAG, domain_p->receiveBuffer, bufferSize, MPI_INT,
+    domain_p->upRank, TAG, MPI_COMM_WORLD, &status);
+  MPI_Get_count(&status, MPI_INT, &receiveCount);
+  receiveParticles(domain_p->receiveBuffer, receiveCount, particleList_p,
+    flask1_p, flask2_p);
+
+  exchangeHalos(*domain_p, flask1_p, flask2_p);
+
+}
+
+/**
+ * Copy the first and last rows of this process's block of each flask into
+ * the border rows of the neighboring processes' blocks.
+ *
+ * @param domain the domain
+ * @param flask1_p pointer to the first flask
+ * @param flask2_p pointer to the second flask
+ */
+void exchangeHalos(const domain_type domain, flask_type *flask1_p,
+    flask_type *flask2_p) {
+
+  flask_type * const flasks[2] = { flask1_p, flask2_p };
+  MPI_Request requests[8];
+  flask_type *flask_p;
+  int flaskIdx;
+
+  /* Include the border columns, so each row is one contiguous message */
+  for (flaskIdx = 0; flaskIdx < 2; flaskIdx++) {
+    flask_p = flasks[flaskIdx];
+    MPI_Irecv(&FLASK_CELL(*flask_p, domain.firstRowIdx - 1, -1),
+      flask_p->rowStride, MPI_INT, domain.upRank, TAG, MPI_COMM_WORLD,
+      &requests[4*flaskIdx]);
+    MPI_Irecv(&FLASK_CELL(*flask_p, domain.endRowIdx, -1),
+      flask_p->rowStride, MPI_INT, domain.downRank, TAG, MPI_COMM_WORLD,
+      &requests[4*flaskIdx+1]);
+    MPI_Isend(&FLASK_CELL(*flask_p, domain.firstRowIdx, -1),
+      flask_p->rowStride, MPI_INT, domain.upRank, TAG, MPI_COMM_WORLD,
+      &requests[4*flaskIdx+2]);
+    MPI_Isend(&FLASK_CELL(*flask_p, domain.endRowIdx - 1, -1),
+      flask_p->rowStride, MPI_INT, domain.downRank, TAG, MPI_COMM_WORLD,
+      &requests[4*flaskIdx+3]);
+  }
+  MPI_Waitall(8, requests, MPI_STATUSES_IGNORE);
+
+}
+
+/**
+ * Compare two ints for sorting in descending order.
+ *
+ * @param a pointer to the first int
+ * @param b pointer to the second int
+ * @return negative, zero or positive if the first int is greater than, equal
+ *   to, or less than the second
+ */
+static int compareDescending(const void *a, const void *b) {
+
+  return (*(const int*)b > *(const int*)a) - (*(const int*)b < *(const int*)a);
+
+}
+
+/**
+ * Remove the particles that have left this process's block during the time
+ * step from the particle list, and start recording the next time step.
+ *
+ * @param domain_p pointer to the domain
+ * @param particleList_p pointer to the list of particles
+ */
+void removeMigrants(domain_type *domain_p,
+    particle_list_type *particleList_p) {
+
+  int i, particleIdx;
+
+  /* Going from the back, every particle after the current gap is one to
+   * keep, so the last one can fill the gap */
+  qsort(domain_p->migrantIdxs, domain_p->migrantCount, sizeof(int),
+    compareDescending);
+  for (i = 0; i < domain_p->migrantCount; i++) {
+    particleIdx = domain_p->migrantIdxs[i];
+    particleList_p->count--;
+    particleList_p->elements[particleIdx] =
+      particleList_p->elements[particleList_p->count];
+  }
+
+  domain_p->migrantCount = 0;
+  domain_p->sentCount = 0;
+
+}
+
+/**
+ * Free memory for a domain.
+ *
+ * @param domain_p pointer to the domain for which to free memory
+ */
+void freeDomain(domain_type *domain_p) {
+
+  free(domain_p->receiveBuffer);
+  free(domain_p->sendDownBuffer);
+  free(domain_p->sendUpBuffer);
+  free(domain_p->migrantIdxs);
+
+}
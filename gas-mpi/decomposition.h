@@ -0,0 +1,87 @@
+/**
+ * HPCU Bi-Weekly Challenge: Distributed Ideal Gas
+ * MPI version
+ * Decomposition - defines functions for splitting one large simulation into
+ * blocks of rows, one per process, and for exchanging the cells and particles
+ * on the edges of those blocks.
+ *
+ * @author Aaron Weeden, Shodor Education Foundation
+ * @version 3.1
+ * @since 3.1
+ */
+#ifndef DECOMPOSITION_H
+#define DECOMPOSITION_H
+
+#include "typedefs.h"
+
+/**
+ * Split the rows of the flasks evenly across the processes, keeping both
+ * stopcock rows in the same block so that every move through a stopcock
+ * happens within one process, and allocate the message buffers.  Exits if
+ * some process would get no rows.
+ *
+ * @param domain_p pointer to the domain to initialize
+ * @param rowCount the number of rows in the taller flask
+ * @param stopcockRow1 the row of the first flask's stopcock
+ * @param stopcockRow2 the row of the second flask's stopcock
+ * @param columnCount the number of columns in both flasks together
+ */
+void initializeDomain(domain_type *domain_p, const int rowCount,
+    const int stopcockRow1, const int stopcockRow2, const int columnCount);
+
+/**
+ * Note that a particle has just moved, and if it moved out of this process's
+ * block, add it to the particles to send to the neighboring process.  Can be
+ * called by several OpenMP threads at once.
+ *
+ * @param domain_p pointer to the domain
+ * @param particleList_p pointer to the list of particles
+ * @param particleIdx index in the list of the particle that moved
+ */
+void recordMove(domain_type *domain_p, particle_list_type *particleList_p,
+    const int particleIdx);
+
+/**
+ * Send the particles that have left this process's block since the last call
+ * to the processes that now own them, add the particles arriving from the
+ * neighboring processes to the flasks and the particle list, and then
+ * exchange the rows on the edges of the blocks.
+ *
+ * @param domain_p pointer to the domain
+ * @param particleList_p pointer to the list of particles
+ * @param flask1_p pointer to the first flask
+ * @param flask2_p pointer to the second flask
+ */
+void exchangeMigrants(domain_type *domain_p,
+    particle_list_type *particleList_p, flask_type *flask1_p,
+    flask_type *flask2_p);
+
+/**
+ * Copy the first and last rows of this process's block of each flask into
+ * the border rows of the neighboring processes' blocks.
+ *
+ * @param domain the domain
+ * @param flask1_p pointer to the first flask
+ * @param flask2_p pointer to the second flask
+ */
+void exchangeHalos(const domain_type domain, flask_type *flask1_p,
+    flask_type *flask2_p);
+
+/**
+ * Remove the particles that have left this process's block during the time
+ * step from the particle list, and start recording the next time step.
+ *
+ * @param domain_p pointer to the domain
+ * @param particleList_p pointer to the list of particles
+ */
+void removeMigrants(domain_type *domain_p,
+    particle_list_type *particleList_p);
+
+/**
+ * Free memory for a domain.
+ *
+ * @param domain_p pointer to the domain for which to free memory
+ */
+void freeDomain(domain_type *domain_p);
+
+#endif
@@ -14,6 +14,7 @@
 #include <stdlib.h>
 #include "constants.h"
 #include "memory-management.h"
+#include "random.h"
 #include "initialization.h"
 
 /**
@@ -24,9 +25,14 @@
  * @param rowCount the number of rows to assign to the flask
  * @param columnCount the number of columns to assign to the flask
  * @param stopcockRow the row in which the flask's stopcock should be located
+ * @param firstRowIdx the first row whose cells this process stores
+ * @param localRowCount the number of rows whose cells this process stores;
+ *   these may extend past the bottom of the flask, in which case they are
+ *   walls
  */
 void initializeFlask(flask_type *flask_p, const int id, const int rowCount,
-    const int columnCount, const int stopcockRow) {
+    const int columnCount, const int stopcockRow, const int firstRowIdx,
+    const int localRowCount) {
 
   int rowIdx, columnIdx;
 
@@ -34,21 +40,31 @@ void initializeFlask(flask_type *flask_p, const int id, const int rowCount,
   flask_p->rowCount = rowCount;
   flask_p->columnCount = columnCount;
   flask_p->stopcockRow = stopcockRow;
+  flask_p->firstRowIdx = firstRowIdx;
+  flask_p->localRowCount = localRowCount;
 
   allocateFlaskCells(flask_p);
 
-  for (rowIdx = 0; rowIdx < rowCount; rowIdx++) {
-    for (columnIdx = 0; columnIdx < columnCount; columnIdx++) {
-      flask_p->cells[rowIdx][columnIdx] = EMPTY;
+  /* Rows belonging to neighboring processes start empty and are filled in by
+   * the first exchange of halos */
+  for (rowIdx = firstRowIdx - 1; rowIdx <= firstRowIdx + localRowCount;
+      rowIdx++) {
+    for (columnIdx = -1; columnIdx <= columnCount; columnIdx++) {
+      FLASK_CELL(*flask_p, rowIdx, columnIdx) =
+        (rowIdx < 0 || rowIdx >= rowCount ||
+         columnIdx < 0 || columnIdx == columnCount) ? WALL : EMPTY;
     }
   }
 
   flask_p->stopcockCell = EMPTY;
+  flask_p->particleCount = 0;
 
 }
 
 /**
- * Allocate memory for particles and initialize their data.
+ * Allocate memory for particles and initialize their data.  Only the
+ * particles in the rows of the flask stored by this process are created, but
+ * every particle gets the same unique ID however the flask is decomposed.
  *
  * @param particleList_p pointer to the list of particles to initialize
  * @param flask_p pointer to the flask in which to place the particles.  This
@@ -60,24 +76,87 @@ void initializeParticles(particle_list_type *particleList_p,
     flask_type *flask_p, const int blockRowCount, const int blockColumnCount,
     const int topRow, const int leftColumn) {
 
+  const int firstRowIdx = (flask_p->firstRowIdx > topRow) ?
+    (flask_p->firstRowIdx - topRow) : 0;
+  const int endRowIdx =
+    (flask_p->firstRowIdx + flask_p->localRowCount < topRow + blockRowCount) ?
+    (flask_p->firstRowIdx + flask_p->localRowCount - topRow) : blockRowCount;
   int particleIdx, rowIdx, columnIdx;
 
-  particleList_p->count = blockRowCount * blockColumnCount;
+  particleList_p->count = (endRowIdx > firstRowIdx) ?
+    (endRowIdx - firstRowIdx) * blockColumnCount : 0;
   allocateParticles(particleList_p);
+  flask_p->particleCount += particleList_p->count;
 
   particleIdx = 0;
-  for (rowIdx = 0; rowIdx < blockRowCount; rowIdx++) {
+  for (rowIdx = firstRowIdx; rowIdx < endRowIdx; rowIdx++) {
     for (columnIdx = 0; columnIdx < blockColumnCount; columnIdx++) {
-      flask_p->cells[topRow + rowIdx][leftColumn + columnIdx] = particleIdx;
-      particleList_p->elements[particleIdx].id = particleIdx;
+      FLASK_CELL(*flask_p, topRow + rowIdx, leftColumn + columnIdx) =
+        rowIdx * blockColumnCount + columnIdx;
+      particleList_p->elements[particleIdx].id =
+        rowIdx * blockColumnCount + columnIdx;
       particleList_p->elements[particleIdx].rowIdx = topRow + rowIdx;
       particleList_p->elements[particleIdx].columnIdx = leftColumn + columnIdx;
-      particleList_p->elements[particleIdx].flask_p = flask_p;
-      particleList_p->elements[particleIdx].isInStopcock = false;
+      particleList_p->elements[particleIdx].flags =
+        (1 == flask_p->id) ? 0u : PARTICLE_IN_FLASK_2;
       particleIdx++;
     }
   }
 
 }
 
+/**
+ * Allocate memory for particles and place one in each cell of a flask with a
+ * given probability.  Whether a cell gets a particle depends only on the seed
+ * and the cell, and the particle's unique ID is the index of the cell, so the
+ * particles are the same however the flask is decomposed.  Only the particles
+ * in the rows of the flask stored by this process are created.
+ *
+ * @param particleList_p pointer to the list of particles to initialize
+ * @param flask_p pointer to the flask in which to place the particles.  This
+ *   flask must have been previously initialized or an error may occur.
+ * @param density the probability that a cell gets a particle
+ * @param seed the seed for choosing the cells
+ */
+void initializeParticlesRandomly(particle_list_type *particleList_p,
+    flask_type *flask_p, const double density, const unsigned int seed) {
+
+  const int firstRowIdx = flask_p->firstRowIdx;
+  const int endRowIdx =
+    (flask_p->firstRowIdx + flask_p->localRowCount < flask_p->rowCount) ?
+    (flask_p->firstRowIdx + flask_p->localRowCount) : flask_p->rowCount;
+  int particleIdx, rowIdx, columnIdx;
+  long cellIdx;
+
+  /* Count the particles first so the list is allocated once */
+  particleList_p->count = 0;
+  for (rowIdx = firstRowIdx; rowIdx < endRowIdx; rowIdx++) {
+    for (columnIdx = 0; columnIdx < flask_p->columnCount; columnIdx++) {
+      cellIdx = (long)rowIdx * flask_p->columnCount + columnIdx;
+      if (randomUniformAt(seed, cellIdx) < density) {
+        particleList_p->count++;
+      }
+    }
+  }
+  allocateParticles(particleList_p);
+  flask_p->particleCount += particleList_p->count;
+
+  particleIdx = 0;
+  for (rowIdx = firstRowIdx; rowIdx < endRowIdx; rowIdx++) {
+    for (columnIdx = 0; columnIdx < flask_p->columnCount; columnIdx++) {
+      cellIdx = (long)rowIdx * flask_p->columnCount + columnIdx;
+      if (randomUniformAt(seed, cellIdx) < density) {
+        FLASK_CELL(*flask_p, rowIdx, columnIdx) = (int)cellIdx;
+        particleList_p->elements[particleIdx].id = (int)cellIdx;
+        particleList_p->elements[particleIdx].rowIdx = rowIdx;
+        particleList_p->elements[particleIdx].columnIdx = columnIdx;
+        particleList_p->elements[particleIdx].flags =
+          (1 == flask_p->id) ? 0u : PARTICLE_IN_FLASK_2;
+        particleIdx++;
+      }
+    }
+  }
+
+}
+
 #endif
@@ -21,12 +21,19 @@
  * @param rowCount the number of rows to assign to the flask
  * @param columnCount the number of columns to assign to the flask
  * @param stopcockRow the row in which the flask's stopcock should be located
+ * @param firstRowIdx the first row whose cells this process stores
+ * @param localRowCount the number of rows whose cells this process stores;
+ *   these may extend past the bottom of the flask, in which case they are
+ *   walls
  */
 void initializeFlask(flask_type *flask_p, const int id, const int rowCount,
-    const int columnCount, const int stopcockRow);
+    const int columnCount, const int stopcockRow, const int firstRowIdx,
+    const int localRowCount);
 
 /**
- * Allocate memory for particles and initialize their data.
+ * Allocate memory for particles and initialize their data.  Only the
+ * particles in the rows of the flask stored by this process are created, but
+ * every particle gets the same unique ID however the flask is decomposed.
  *
  * @param particleList_p pointer to the list of particles to initialize
  * @param flask pointer to the flask in which to place the particles.  This
@@ -38,4 +45,20 @@ void initializeParticles(particle_list_type *particleList_p,
     flask_type *flask_p, const int blockRowCount, const int blockColumnCount,
     const int topRow, const int leftColumn);
 
+/**
+ * Allocate memory for particles and place one in each cell of a flask with a
+ * given probability.  Whether a cell gets a particle depends only on the seed
+ * and the cell, and the particle's unique ID is the index of the cell, so the
+ * particles are the same however the flask is decomposed.  Only the particles
+ * in the rows of the flask stored by this process are created.
+ *
+ * @param particleList_p pointer to the list of particles to initialize
+ * @param flask_p pointer to the flask in which to place the particles.  This
+ *   flask must have been previously initialized or an error may occur.
+ * @param density the probability that a cell gets a particle
+ * @param seed the seed for choosing the cells
+ */
+void initializeParticlesRandomly(particle_list_type *particleList_p,
+    flask_type *flask_p, const double density, const unsigned int seed);
+
 #endif
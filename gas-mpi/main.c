@@ -4,6 +4,11 @@
  * Main file - runs a simulation of particles moving randomly in and between
  * two flasks connected by one stopcock per flask.
  *
+ * By default every process runs its own copy of the simulation and the final
+ * ratios are averaged.  With the -d option the processes instead run one
+ * simulation together, each owning a block of rows of both flasks.  See
+ * config.h for the options that set the size of the simulation.
+ *
  * @author Aaron Weeden, Shodor Education Foundation
  * @version 3.0
  * @since 1.0
@@ -12,11 +17,18 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <time.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 #include "constants.h"
 #include "typedefs.h"
 #include "initialization.h"
 #include "simulation.h"
 #include "memory-management.h"
+#include "random.h"
+#include "decomposition.h"
+#include "config.h"
+#include "snapshot.h"
 
 /**
  * Runs the program.
@@ -27,52 +39,159 @@
  */
 int main(int argc, char **argv) {
 
-  /* Declare constants whose values depend on other constants */
-  const double V1 = FLASK_1_ROW_COUNT * FLASK_1_COLUMN_COUNT + 1.0;
-  const double V2 = FLASK_2_ROW_COUNT * FLASK_2_COLUMN_COUNT + 1.0;
-  const double VRATIO = V1 / V2;
-
   /* Declare model data */
+  config_type config;
   flask_type flask1, flask2;
   particle_list_type particleList;
-  double ratio, sum;
+  double vratio, ratio, sum;
+  int rowCount, timeCount;
+  FILE *statisticsFile = NULL;
+  snapshot_writer_type snapshots;
+  bool isSnapshotting;
+
+  /* Declare decomposition data */
+  domain_type domain;
+  int firstRowIdx, localRowCount;
+  long particleCount, totalParticleCount;
+  double moveCount, totalMoveCount;
+
+  /* Declare timing data */
+  double startTime, elapsedTime, maxElapsedTime;
 
   /* Declare MPI variables */
-  int mpi_rank, mpi_size;
+  int mpi_rank, mpi_size, mpi_thread_support;
+  unsigned int defaultSeed;
 
-  /* Initialize MPI */
-  MPI_Init(&argc, &argv);
+  /* Initialize MPI; only the master thread makes MPI calls */
+  MPI_Init_thread(&argc, &argv, MPI_THREAD_FUNNELED, &mpi_thread_support);
 
   /* Set up MPI rank and size */
   MPI_Comm_rank(MPI_COMM_WORLD, &mpi_rank);
   MPI_Comm_size(MPI_COMM_WORLD, &mpi_size);
 
-  /* Seed random number generator */
-  srandom(time(NULL));
+#ifdef _OPENMP
+  /* Below MPI_THREAD_FUNNELED a process may not run other threads at all, so
+   * the OpenMP loops must run on one thread */
+  if (mpi_thread_support < MPI_THREAD_FUNNELED) {
+    if (mpi_rank == 0) {
+      fprintf(stderr, "MPI_THREAD_FUNNELED is not supported; running one "
+        "thread per process\n");
+    }
+    omp_set_num_threads(1);
+  }
+#endif
+
+  /* Read command-line options; all processes default to rank 0's seed */
+  defaultSeed = (unsigned int)time(NULL);
+  MPI_Bcast(&defaultSeed, 1, MPI_UNSIGNED, 0, MPI_COMM_WORLD);
+  initializeConfig(&config, argc, argv, defaultSeed);
+
+  /* Calculate values that depend on the config */
+  vratio = ((double)config.flask1RowCount * config.flask1ColumnCount + 1.0) /
+    ((double)config.flask2RowCount * config.flask2ColumnCount + 1.0);
+  rowCount = (config.flask1RowCount > config.flask2RowCount) ?
+    config.flask1RowCount : config.flask2RowCount;
+
+  /* Seed random number generators, with a separate stream for each process
+   * and thread */
+  seedRandom(config.seed, mpi_rank);
+
+  /* Split the rows of the flasks across the processes */
+  firstRowIdx = 0;
+  localRowCount = rowCount;
+  if (config.isDistributed) {
+    initializeDomain(&domain, rowCount, config.flask1StopcockRow,
+      config.flask2StopcockRow,
+      config.flask1ColumnCount + config.flask2ColumnCount);
+    firstRowIdx = domain.firstRowIdx;
+    localRowCount = domain.endRowIdx - domain.firstRowIdx;
+  }
 
   /* Set up flasks and particles */
-  initializeFlask(&flask1, 1, FLASK_1_ROW_COUNT, FLASK_1_COLUMN_COUNT,
-    FLASK_1_STOPCOCK_ROW);
-  initializeFlask(&flask2, 2, FLASK_2_ROW_COUNT, FLASK_2_COLUMN_COUNT,
-    FLASK_2_STOPCOCK_ROW);
-  initializeParticles(&particleList, &flask1, PARTICLE_BLOCK_ROW_COUNT,
-    PARTICLE_BLOCK_COLUMN_COUNT, PARTICLE_BLOCK_TOP_ROW,
-    PARTICLE_BLOCK_LEFT_COLUMN);
+  initializeFlask(&flask1, 1, config.flask1RowCount, config.flask1ColumnCount,
+    config.flask1StopcockRow, firstRowIdx, localRowCount);
+  initializeFlask(&flask2, 2, config.flask2RowCount, config.flask2ColumnCount,
+    config.flask2StopcockRow, firstRowIdx, localRowCount);
+  if (config.fillDensity > 0.0) {
+    initializeParticlesRandomly(&particleList, &flask1, config.fillDensity,
+      config.seed);
+  }
+  else {
+    initializeParticles(&particleList, &flask1, config.blockRowCount,
+      config.blockColumnCount, config.blockTopRow, config.blockLeftColumn);
+  }
+  if (config.isDistributed) {
+    exchangeHalos(domain, &flask1, &flask2);
+  }
+
+  /* Rank 0 writes the statistics */
+  if (mpi_rank == 0 && config.statisticsPath != NULL) {
+    statisticsFile = fopen(config.statisticsPath, "w");
+    if (statisticsFile == NULL) {
+      fprintf(stderr, "Could not open %s, exiting!\n",
+        config.statisticsPath);
+      MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+    }
+    fprintf(statisticsFile, "# time_step n1 n2 ratio\n");
+  }
+
+  /* Rank 0 writes the pictures, gathering them from every process if the
+   * flasks are decomposed */
+  isSnapshotting = (config.snapshotPath != NULL &&
+    (config.isDistributed || mpi_rank == 0));
+  if (isSnapshotting) {
+    initializeSnapshots(&snapshots, config,
+      config.isDistributed ? &domain : NULL, mpi_rank);
+  }
 
   /* Run the simulation */
-  ratio = simulate(&flask1, &flask2, &particleList, TIME_COUNT, VRATIO);
+  startTime = MPI_Wtime();
+  ratio = simulate(&flask1, &flask2, &particleList, config, vratio,
+    config.isDistributed ? &domain : NULL, statisticsFile,
+    isSnapshotting ? &snapshots : NULL, &timeCount);
+  elapsedTime = MPI_Wtime() - startTime;
+
+  if (isSnapshotting) {
+    finishSnapshots(&snapshots);
+  }
+
+  if (statisticsFile != NULL) {
+    fclose(statisticsFile);
+  }
 
   /* Rank 0 collects final ratios and sums them */
   MPI_Reduce(&ratio, &sum, 1, MPI_DOUBLE, MPI_SUM, 0, MPI_COMM_WORLD);
 
+  /* Rank 0 collects the slowest simulation time */
+  MPI_Reduce(&elapsedTime, &maxElapsedTime, 1, MPI_DOUBLE, MPI_MAX, 0,
+    MPI_COMM_WORLD);
+
+  /* Rank 0 counts the particles and moves on all processes */
+  particleCount = particleList.count;
+  MPI_Reduce(&particleCount, &totalParticleCount, 1, MPI_LONG, MPI_SUM, 0,
+    MPI_COMM_WORLD);
+  moveCount = (double)particleList.count * timeCount;
+  MPI_Reduce(&moveCount, &totalMoveCount, 1, MPI_DOUBLE, MPI_SUM, 0,
+    MPI_COMM_WORLD);
+
   /* Release allocated memory */
-  free(particleList.elements);
+  if (config.isDistributed) {
+    freeDomain(&domain);
+  }
+  freeParticles(&particleList);
   freeFlask(&flask2);
   freeFlask(&flask1);
 
   /* Rank 0 averages ratios and prints the result */
   if (mpi_rank == 0) {
+    printConfig(config, mpi_size);
+    printf("Particles = %ld\n", totalParticleCount);
+    if (config.tolerance > 0.0) {
+      printf("Time steps run = %d\n", timeCount);
+    }
     printf("Final ratio = %f\n", (sum/mpi_size));
+    printf("Particle moves per second = %e\n",
+      (totalMoveCount / maxElapsedTime));
   }
 
   /* Finalize MPI */
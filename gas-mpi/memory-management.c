@@ -11,22 +11,30 @@
 #ifndef MEMORY_MANAGEMENT_C
 #define MEMORY_MANAGEMENT_C
 
+#include <stdio.h>
 #include <stdlib.h>
+#include "constants.h"
 #include "typedefs.h"
 
 /**
- * Allocate memory for a flask's cells.
+ * Allocate memory for a flask's cells, including the border around them, as
+ * one contiguous block aligned to a cache line.
  *
  * @param flask_p pointer to the flask whose cells' memory should be allocated
  */
 void allocateFlaskCells(flask_type *flask_p) {
 
-  int i;
+  void *cells;
 
-  flask_p->cells = (int**)malloc(flask_p->rowCount * sizeof(int*));
-  for (i = 0; i < flask_p->rowCount; i++) {
-    flask_p->cells[i] = (int*)malloc(flask_p->columnCount * sizeof(int));
+  flask_p->rowStride = flask_p->columnCount + 2;
+  if (posix_memalign(&cells, CELL_ALIGNMENT,
+        (size_t)(flask_p->localRowCount + 2) * flask_p->rowStride *
+        sizeof(int)) != 0) {
+    fprintf(stderr, "Could not allocate flask %d cells, exiting!\n",
+      flask_p->id);
+    exit(EXIT_FAILURE);
   }
+  flask_p->cells = (int*)cells;
 
 }
 
@@ -38,8 +46,57 @@ void allocateFlaskCells(flask_type *flask_p) {
  */
 void allocateParticles(particle_list_type *particleList_p) {
 
-  particleList_p->elements = (particle_type*)malloc(particleList_p->count *
+  particleList_p->capacity =
+    (particleList_p->count > 0) ? particleList_p->count : 1;
+  particleList_p->elements = (particle_type*)malloc(particleList_p->capacity *
     sizeof(particle_type));
+  particleList_p->phases = (unsigned char*)malloc(particleList_p->capacity *
+    sizeof(unsigned char));
+  if (particleList_p->elements == NULL || particleList_p->phases == NULL) {
+    fprintf(stderr, "Could not allocate %d particles, exiting!\n",
+      particleList_p->capacity);
+    exit(EXIT_FAILURE);
+  }
+
+}
+
+/**
+ * Make room in a particle list for at least a given number of particles,
+ * doubling its capacity as needed.
+ *
+ * @param particleList_p pointer to the particle list to grow
+ * @param count the number of particles the list must be able to hold
+ */
+void growParticles(particle_list_type *particleList_p, const int count) {
+
+  if (count <= particleList_p->capacity) {
+    return;
+  }
+
+  while (particleList_p->capacity < count) {
+    particleList_p->capacity *= 2;
+  }
+  particleList_p->elements = (particle_type*)realloc(particleList_p->elements,
+    particleList_p->capacity * sizeof(particle_type));
+  particleList_p->phases = (unsigned char*)realloc(particleList_p->phases,
+    particleList_p->capacity * sizeof(unsigned char));
+  if (particleList_p->elements == NULL || particleList_p->phases == NULL) {
+    fprintf(stderr, "Could not allocate %d particles, exiting!\n",
+      particleList_p->capacity);
+    exit(EXIT_FAILURE);
+  }
+
+}
+
+/**
+ * Free memory for a particle list.
+ *
+ * @param particleList_p pointer to the particle list for which to free memory
+ */
+void freeParticles(particle_list_type *particleList_p) {
+
+  free(particleList_p->phases);
+  free(particleList_p->elements);
 
 }
 
@@ -50,11 +107,6 @@ void allocateParticles(particle_list_type *particleList_p) {
  */
 void freeFlask(flask_type *flask_p) {
 
-  int i;
-
-  for (i = flask_p->rowCount-1; i >= 0; i--) {
-    free(flask_p->cells[i]);
-  }
   free(flask_p->cells);
 
 }
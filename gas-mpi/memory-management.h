@@ -14,7 +14,8 @@
 #include "typedefs.h"
 
 /**
- * Allocate memory for a flask's cells.
+ * Allocate memory for a flask's cells, including the border around them, as
+ * one contiguous block aligned to a cache line.
  *
  * @param flask_p pointer to the flask whose cells' memory should be allocated
  */
@@ -28,6 +29,22 @@ void allocateFlaskCells(flask_type *flask_p);
  */
 void allocateParticles(particle_list_type *particleList_p);
 
+/**
+ * Make room in a particle list for at least a given number of particles,
+ * doubling its capacity as needed.
+ *
+ * @param particleList_p pointer to the particle list to grow
+ * @param count the number of particles the list must be able to hold
+ */
+void growParticles(particle_list_type *particleList_p, const int count);
+
+/**
+ * Free memory for a particle list.
+ *
+ * @param particleList_p pointer to the particle list for which to free memory
+ */
+void freeParticles(particle_list_type *particleList_p);
+
 /**
  * Free memory for a flask.
  *
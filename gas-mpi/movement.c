@@ -7,8 +7,10 @@
  * @version 3.0
  * @since 1.0
  */
+#include <stddef.h>
 #include "constants.h"
 #include "random.h"
+#include "decomposition.h"
 #include "movement.h"
 
 /**
@@ -25,16 +27,17 @@ open_direction_list_type calculateOpenDirections(const particle_type particle,
   open_direction_list_type openDirectionList;
 
   openDirectionList.count = 0;
-  if (particle.isInStopcock) {
-    if (1 == particle.flask_p->id) {
+  if (PARTICLE_IS_IN_STOPCOCK(particle)) {
+    if (1 == PARTICLE_FLASK_ID(particle)) {
       if (flask2.stopcockCell == EMPTY) {
         openDirectionList.elements[openDirectionList.count++] =
           INTO_FLASK_2_STOPCOCK;
       }
-      if (flask1.cells[flask1.stopcockRow][flask1.columnCount-1] == EMPTY) {
+      if (FLASK_CELL(flask1, flask1.stopcockRow, flask1.columnCount-1) ==
+          EMPTY) {
         openDirectionList.elements[openDirectionList.count++] = LEFT;
       }
-      if (flask2.cells[flask1.stopcockRow][0] == EMPTY) {
+      if (FLASK_CELL(flask2, flask1.stopcockRow, 0) == EMPTY) {
         openDirectionList.elements[openDirectionList.count++] = RIGHT;
       }
     }
@@ -43,34 +46,37 @@ open_direction_list_type calculateOpenDirections(const particle_type particle,
         openDirectionList.elements[openDirectionList.count++] =
           INTO_FLASK_1_STOPCOCK;
       }
-      if (flask1.cells[flask2.stopcockRow][flask1.columnCount-1] == EMPTY) {
+      if (FLASK_CELL(flask1, flask2.stopcockRow, flask1.columnCount-1) ==
+          EMPTY) {
         openDirectionList.elements[openDirectionList.count++] = LEFT;
       }
-      if (flask2.cells[flask2.stopcockRow][0] == EMPTY) {
+      if (FLASK_CELL(flask2, flask2.stopcockRow, 0) == EMPTY) {
         openDirectionList.elements[openDirectionList.count++] = RIGHT;
       }
     }
   }
   else {
-    if (particle.rowIdx > 0 &&
-        particle.flask_p->cells[particle.rowIdx-1][particle.columnIdx] == EMPTY) {
+    /* The border of WALL cells means the neighbors are always in bounds */
+    const flask_type *flask_p = PARTICLE_FLASK(particle, &flask1, &flask2);
+    const int *cell_p = &FLASK_CELL(*flask_p, particle.rowIdx,
+      particle.columnIdx);
+    const int rowStride = flask_p->rowStride;
+
+    if (cell_p[-rowStride] == EMPTY) {
       openDirectionList.elements[openDirectionList.count++] = UP;
     }
-    if (particle.columnIdx > 0 &&
-        particle.flask_p->cells[particle.rowIdx][particle.columnIdx-1] == EMPTY) {
+    if (cell_p[-1] == EMPTY) {
       openDirectionList.elements[openDirectionList.count++] = LEFT;
     }
-    if (particle.rowIdx < particle.flask_p->rowCount-1 &&
-        particle.flask_p->cells[particle.rowIdx+1][particle.columnIdx] == EMPTY) {
+    if (cell_p[rowStride] == EMPTY) {
       openDirectionList.elements[openDirectionList.count++] = DOWN;
     }
-    if (particle.columnIdx < particle.flask_p->columnCount-1 &&
-        particle.flask_p->cells[particle.rowIdx][particle.columnIdx+1] == EMPTY) {
+    if (cell_p[1] == EMPTY) {
       openDirectionList.elements[openDirectionList.count++] = RIGHT;
     }
-    if ((1 == particle.flask_p->id &&
+    if ((1 == PARTICLE_FLASK_ID(particle) &&
           particle.columnIdx == flask1.columnCount-1) ||
-        (2 == particle.flask_p->id &&
+        (2 == PARTICLE_FLASK_ID(particle) &&
          particle.columnIdx == 0)) {
       if (flask1.stopcockCell == EMPTY &&
           particle.rowIdx == flask1.stopcockRow) {
@@ -93,21 +99,27 @@ open_direction_list_type calculateOpenDirections(const particle_type particle,
  * Given a particle, removes it from its containing flask.
  *
  * @param particle_p pointer the particle to remove
+ * @param flask1_p pointer to the first flask
+ * @param flask2_p pointer to the second flask
  */
-void removeParticleFromFlaskCell(particle_type *particle_p) {
+void removeParticleFromFlaskCell(const particle_type *particle_p,
+    flask_type * const flask1_p, flask_type * const flask2_p) {
 
-  if (particle_p->isInStopcock) {
-    particle_p->flask_p->stopcockCell = EMPTY;
+  flask_type * const flask_p = PARTICLE_FLASK(*particle_p, flask1_p, flask2_p);
+
+  if (PARTICLE_IS_IN_STOPCOCK(*particle_p)) {
+    flask_p->stopcockCell = EMPTY;
   }
   else {
-    particle_p->flask_p->cells[particle_p->rowIdx][particle_p->columnIdx] =
-      EMPTY;
+    FLASK_CELL(*flask_p, particle_p->rowIdx, particle_p->columnIdx) = EMPTY;
   }
 
 }
 
 /**
- * Given a particle, moves it in a given direction.
+ * Given a particle, moves it in a given direction.  If it changes flasks, the
+ * flasks' particle counts are updated; this only happens in or next to a
+ * stopcock, so never on two threads at once.
  *
  * @param particle_p pointer to the particle to move
  * @param direction the direction for the particle to move
@@ -120,78 +132,243 @@ void moveParticleInDirection(particle_type *particle_p, const int direction,
   const int rowIdx = particle_p->rowIdx;
   int columnIdx = particle_p->columnIdx;
   const int id = particle_p->id;
-  const bool isInStopcock = particle_p->isInStopcock;
+  const bool isInStopcock = PARTICLE_IS_IN_STOPCOCK(*particle_p);
+  flask_type * const flask_p = PARTICLE_FLASK(*particle_p, flask1_p, flask2_p);
+  flask_type *newFlask_p = flask_p;
 
-  removeParticleFromFlaskCell(particle_p);
+  removeParticleFromFlaskCell(particle_p, flask1_p, flask2_p);
 
   switch(direction) {
     case UP:
-      particle_p->flask_p->cells[rowIdx-1][columnIdx] = id;
+      FLASK_CELL(*flask_p, rowIdx-1, columnIdx) = id;
       particle_p->rowIdx = rowIdx-1;
       break;
     case LEFT:
       if (isInStopcock) {
-        particle_p->flask_p = flask1_p;
+        newFlask_p = flask1_p;
         columnIdx = flask1_p->columnCount;
       }
-      particle_p->flask_p->cells[rowIdx][columnIdx-1] = id;
+      FLASK_CELL(*newFlask_p, rowIdx, columnIdx-1) = id;
       particle_p->columnIdx = columnIdx-1;
-      particle_p->isInStopcock = false;
+      particle_p->flags &= ~PARTICLE_IN_STOPCOCK;
       break;
     case DOWN:
-      particle_p->flask_p->cells[rowIdx+1][columnIdx] = id;
+      FLASK_CELL(*flask_p, rowIdx+1, columnIdx) = id;
       particle_p->rowIdx = rowIdx+1;
       break;
     case RIGHT:
       if (isInStopcock) {
-        particle_p->flask_p = flask2_p;
+        newFlask_p = flask2_p;
         columnIdx = -1;
       }
-      particle_p->flask_p->cells[rowIdx][columnIdx+1] = id;
+      FLASK_CELL(*newFlask_p, rowIdx, columnIdx+1) = id;
       particle_p->columnIdx = columnIdx+1;
-      particle_p->isInStopcock = false;
+      particle_p->flags &= ~PARTICLE_IN_STOPCOCK;
       break;
     case INTO_FLASK_1_STOPCOCK:
     case INTO_FLASK_2_STOPCOCK:
       if (INTO_FLASK_1_STOPCOCK == direction) {
-        particle_p->flask_p = flask1_p;
+        newFlask_p = flask1_p;
       }
       else {
-        particle_p->flask_p = flask2_p;
+        newFlask_p = flask2_p;
       }
-      particle_p->flask_p->stopcockCell = id;
-      particle_p->isInStopcock = true;
+      newFlask_p->stopcockCell = id;
+      particle_p->flags |= PARTICLE_IN_STOPCOCK;
       break;
     }
 
+  if (newFlask_p != flask_p) {
+    particle_p->flags ^= PARTICLE_IN_FLASK_2;
+    flask_p->particleCount--;
+    newFlask_p->particleCount++;
+  }
+
+}
+
+/**
+ * Given a particle, calculate the phase of the time step in which it moves:
+ * STOPCOCK_PHASE if it is in a stopcock or could move into one, and otherwise
+ * a colour such that particles of the same colour are at least 3 cells apart.
+ *
+ * @param particle the particle
+ * @param flask1 the first flask
+ * @param flask2 the second flask
+ * @return the phase
+ */
+int calculateMovePhase(const particle_type particle, const flask_type flask1,
+    const flask_type flask2) {
+
+  if (PARTICLE_IS_IN_STOPCOCK(particle) ||
+      ((particle.rowIdx == flask1.stopcockRow ||
+        particle.rowIdx == flask2.stopcockRow) &&
+       ((1 == PARTICLE_FLASK_ID(particle) &&
+         particle.columnIdx == flask1.columnCount-1) ||
+        (2 == PARTICLE_FLASK_ID(particle) && particle.columnIdx == 0)))) {
+    return STOPCOCK_PHASE;
+  }
+
+  return (particle.rowIdx + 2 * particle.columnIdx) % COLOR_COUNT;
+
+}
+
+/**
+ * Moves a particle at most 1 square in a random open direction.
+ *
+ * @param particle_p pointer to the particle to move
+ * @param flask1_p pointer to the first flask
+ * @param flask2_p pointer to the second flask
+ */
+static void moveParticleRandomly(particle_type *particle_p,
+    flask_type *flask1_p, flask_type *flask2_p) {
+
+  const open_direction_list_type openDirectionList =
+    calculateOpenDirections((*particle_p), (*flask1_p), (*flask2_p));
+
+  if (openDirectionList.count > 0) {
+    moveParticleInDirection(particle_p,
+      openDirectionList.elements[randomInt(openDirectionList.count)],
+      flask1_p, flask2_p);
+  }
+
+}
+
+/**
+ * Calculate the order in which the phases of a time step run, a random
+ * permutation that depends only on the seed and the time step, so that every
+ * process and thread runs them in the same order.
+ *
+ * A fixed order would change the physics, not just the scheduling: the
+ * particles next to a stopcock would always move after their neighbours had,
+ * and far fewer of them would get through.  Shuffling every time step keeps
+ * the ratios close to those of moving the particles one at a time.
+ *
+ * @param phaseOrder the phases, in the order in which they run
+ * @param seed the seed shared by all the processes
+ * @param timeIdx ID of the time step
+ */
+static void calculatePhaseOrder(int phaseOrder[PHASE_COUNT],
+    const unsigned int seed, const int timeIdx) {
+
+  int i, j, phase;
+
+  for (i = 0; i < PHASE_COUNT; i++) {
+    phaseOrder[i] = i;
+  }
+
+  /* Fisher-Yates shuffle; the cells drawn by initializeParticlesRandomly()
+   * use the non-negative indices, so the shuffles use the negative ones */
+  for (i = PHASE_COUNT - 1; i > 0; i--) {
+    j = (int)(randomUniformAt(seed,
+          -1 - ((long)timeIdx * PHASE_COUNT + i)) * (i + 1));
+    phase = phaseOrder[i];
+    phaseOrder[i] = phaseOrder[j];
+    phaseOrder[j] = phase;
+  }
+
 }
 
 /**
  * Moves all particles in a list randomly.  Each particle moves at most 1
  * square in a random direction.
  *
+ * The particles are split into phases by calculateMovePhase() at the start of
+ * the time step, and the phases run in the order given by
+ * calculatePhaseOrder().  Within each colour phase no two particles can reach
+ * the same cell or look at a cell another one is moving into or out of, so
+ * the OpenMP threads move them concurrently.  The few particles in or next to
+ * the stopcocks, whose moves couple the two flasks, move one at a time in
+ * their own phase.
+ *
+ * When the flasks are decomposed across processes, the same argument holds
+ * across the edges of the blocks, so the processes also move each phase
+ * concurrently; after each phase the master thread hands the particles that
+ * left the block to their new owners and refreshes the border rows.
+ *
  * @param particleList_p pointer to the list of particles to move randomly
  * @param flask1_p pointer to the first flask
  * @param flask2_p pointer to the second flask
+ * @param domain_p pointer to this process's block of the flasks, or NULL if
+ *   the process holds the whole flasks
+ * @param seed the seed shared by all the processes
+ * @param timeIdx ID of the time step
  */
 void moveParticlesRandomly(particle_list_type *particleList_p,
-   flask_type *flask1_p, flask_type *flask2_p) {
+   flask_type *flask1_p, flask_type *flask2_p, domain_type *domain_p,
+   const unsigned int seed, const int timeIdx) {
 
-  particle_type *particle_p;
-  int particleIdx;
-  open_direction_list_type openDirectionList;
+  int phaseOrder[PHASE_COUNT];
+  int stopcockParticles[MAX_STOPCOCK_PARTICLES];
+  int stopcockParticleCount = 0;
+  int particleIdx, orderIdx, phase, slot, i, j;
+
+  calculatePhaseOrder(phaseOrder, seed, timeIdx);
+
+#pragma omp parallel private(particleIdx, orderIdx, phase, slot, i, j)
+  {
+#pragma omp for schedule(static)
+    for (particleIdx = 0; particleIdx < particleList_p->count;
+        particleIdx++) {
+      phase = calculateMovePhase(particleList_p->elements[particleIdx],
+        (*flask1_p), (*flask2_p));
+      particleList_p->phases[particleIdx] = (unsigned char)phase;
+
+      if (STOPCOCK_PHASE == phase) {
+#pragma omp atomic capture
+        slot = stopcockParticleCount++;
+        stopcockParticles[slot] = particleIdx;
+      }
+    }
 
-  for (particleIdx = 0; particleIdx < particleList_p->count; particleIdx++) {
-    particle_p = &(particleList_p->elements[particleIdx]);
+    for (orderIdx = 0; orderIdx < PHASE_COUNT; orderIdx++) {
+      phase = phaseOrder[orderIdx];
 
-    openDirectionList = calculateOpenDirections((*particle_p),
-      (*flask1_p), (*flask2_p));
+      if (STOPCOCK_PHASE == phase) {
+        /* Move the stopcock particles in the order of the list */
+#pragma omp single
+        {
+          for (i = 1; i < stopcockParticleCount; i++) {
+            for (j = i; j > 0 &&
+                stopcockParticles[j-1] > stopcockParticles[j]; j--) {
+              slot = stopcockParticles[j];
+              stopcockParticles[j] = stopcockParticles[j-1];
+              stopcockParticles[j-1] = slot;
+            }
+          }
+          for (i = 0; i < stopcockParticleCount; i++) {
+            moveParticleRandomly(
+              &(particleList_p->elements[stopcockParticles[i]]),
+              flask1_p, flask2_p);
+            if (domain_p != NULL) {
+              recordMove(domain_p, particleList_p, stopcockParticles[i]);
+            }
+          }
+        }
+      }
+      else {
+#pragma omp for schedule(static)
+        for (particleIdx = 0; particleIdx < particleList_p->count;
+            particleIdx++) {
+          if (particleList_p->phases[particleIdx] == phase) {
+            moveParticleRandomly(&(particleList_p->elements[particleIdx]),
+              flask1_p, flask2_p);
+            if (domain_p != NULL) {
+              recordMove(domain_p, particleList_p, particleIdx);
+            }
+          }
+        }
+      }
 
-    if (openDirectionList.count > 0) {
-      moveParticleInDirection(particle_p,
-        openDirectionList.elements[randomInt(openDirectionList.count)],
-        flask1_p, flask2_p);
+      if (domain_p != NULL) {
+#pragma omp master
+        exchangeMigrants(domain_p, particleList_p, flask1_p, flask2_p);
+#pragma omp barrier
+      }
     }
   }
 
+  if (domain_p != NULL) {
+    removeMigrants(domain_p, particleList_p);
+  }
+
 }
@@ -27,11 +27,16 @@ open_direction_list_type calculateOpenDirections(const particle_type particle,
  * Given a particle, removes it from its containing flask.
  *
  * @param particle_p pointer to the particle to remove
+ * @param flask1_p pointer to the first flask
+ * @param flask2_p pointer to the second flask
  */
-void removeParticleFromFlaskCell(particle_type *particle_p);
+void removeParticleFromFlaskCell(const particle_type *particle_p,
+    flask_type * const flask1_p, flask_type * const flask2_p);
 
 /**
- * Given a particle, moves it in a given direction.
+ * Given a particle, moves it in a given direction.  If it changes flasks, the
+ * flasks' particle counts are updated; this only happens in or next to a
+ * stopcock, so never on two threads at once.
  *
  * @param particle_p pointer to the particle to move
  * @param direction the direction for the particle to move
@@ -41,15 +46,38 @@ void removeParticleFromFlaskCell(particle_type *particle_p);
 void moveParticleInDirection(particle_type *particle_p, const int direction,
     flask_type * const flask1_p, flask_type * const flask2_p);
 
+/**
+ * Given a particle, calculate the phase of the time step in which it moves:
+ * STOPCOCK_PHASE if it is in a stopcock or could move into one, and otherwise
+ * a colour such that particles of the same colour are at least 3 cells apart.
+ *
+ * @param particle the particle
+ * @param flask1 the first flask
+ * @param flask2 the second flask
+ * @return the phase
+ */
+int calculateMovePhase(const particle_type particle, const flask_type flask1,
+    const flask_type flask2);
+
 /**
  * Moves all particles in a list randomly.  Each particle moves at most 1
- * square in a random direction.
+ * square in a random direction.  Particles of the same colour phase move
+ * concurrently on the OpenMP threads; particles in or next to a stopcock move
+ * one at a time in a phase of their own.  The phases run in an order drawn
+ * from the seed and the time step.  When the flasks are decomposed across
+ * processes, particles leaving this process's block are sent to their new
+ * owner after each phase.
  *
  * @param particleList_p pointer to the list of particles to move randomly
  * @param flask1_p pointer to the first flask
  * @param flask2_p pointer to the second flask
+ * @param domain_p pointer to this process's block of the flasks, or NULL if
+ *   the process holds the whole flasks
+ * @param seed the seed shared by all the processes
+ * @param timeIdx ID of the time step
  */
 void moveParticlesRandomly(particle_list_type *particleList_p,
-   flask_type *flask1_p, flask_type *flask2_p);
+   flask_type *flask1_p, flask_type *flask2_p, domain_type *domain_p,
+   const unsigned int seed, const int timeIdx);
 
 #endif
@@ -0,0 +1,144 @@
+/**
+ * HPCU Bi-Weekly Challenge: Distributed Ideal Gas
+ * MPI version
+ * Ordering - defines a function for sorting particles by the cells they are
+ * in, so that consecutive particles touch nearby cells.
+ *
+ * @author Aaron Weeden, Shodor Education Foundation
+ * @version 3.1
+ * @since 3.1
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "constants.h"
+#include "ordering.h"
+
+/**
+ * Number of bits sorted in each pass of the radix sort.
+ */
+#define RADIX_BITS 8
+#define RADIX_SIZE (1 << RADIX_BITS)
+
+/**
+ * Spread the bits of a 32-bit value out to the even bits of a 64-bit value.
+ *
+ * @param x the value
+ * @return the spread value
+ */
+static uint64_t spreadBits(const uint32_t x) {
+
+  uint64_t z = x;
+
+  z = (z | (z << 16)) & 0x0000FFFF0000FFFFull;
+  z = (z | (z << 8)) & 0x00FF00FF00FF00FFull;
+  z = (z | (z << 4)) & 0x0F0F0F0F0F0F0F0Full;
+  z = (z | (z << 2)) & 0x3333333333333333ull;
+  z = (z | (z << 1)) & 0x5555555555555555ull;
+  return z;
+
+}
+
+/**
+ * Return a particle's sort key: its flask in the top bit, then either its row
+ * and column, or the row and column bits of its cell interleaved.  Rows and
+ * columns fit in 31 bits, so they never reach the flask bit.
+ *
+ * @param particle the particle
+ * @param isMortonOrder true for the interleaved (Morton) order, false for
+ *   row-major order
+ * @return the sort key
+ */
+static uint64_t calculateSortKey(const particle_type particle,
+    const bool isMortonOrder) {
+
+  const uint64_t flaskBit =
+    (uint64_t)(particle.flags & PARTICLE_IN_FLASK_2) << 63;
+
+  if (isMortonOrder) {
+    return flaskBit | (spreadBits((uint32_t)particle.rowIdx) << 1) |
+      spreadBits((uint32_t)particle.columnIdx);
+  }
+  return flaskBit | ((uint64_t)particle.rowIdx << 31) |
+    (uint64_t)particle.columnIdx;
+
+}
+
+/**
+ * Sort a list of particles by flask, then by cell, in either row-major order
+ * or Morton (Z) order.  Row-major order matches the layout of the cells, so
+ * the moves of consecutive particles stream through the same few rows.
+ * Morton order also keeps particles in nearby rows close together in the
+ * list, which only pays off once three rows of cells no longer fit in cache.
+ *
+ * Uses a least-significant-digit radix sort, skipping the digits that are
+ * the same for every particle, which for all but the largest flasks are most
+ * of them.
+ *
+ * @param particleList_p pointer to the list of particles to sort
+ * @param isMortonOrder true for Morton order, false for row-major order
+ */
+void sortParticles(particle_list_type *particleList_p,
+    const bool isMortonOrder) {
+
+  const int count = particleList_p->count;
+  uint64_t *keys, *sortedKeys, *swapKeys;
+  particle_type *particles, *sortedParticles, *swapParticles;
+  int offsets[RADIX_SIZE];
+  int shift, digit, i, total;
+
+  if (count < 2) {
+    return;
+  }
+
+  keys = (uint64_t*)malloc(2 * count * sizeof(uint64_t));
+  sortedParticles = (particle_type*)malloc(particleList_p->capacity *
+    sizeof(particle_type));
+  if (keys == NULL || sortedParticles == NULL) {
+    fprintf(stderr, "Could not allocate memory for sorting, exiting!\n");
+    exit(EXIT_FAILURE);
+  }
+  sortedKeys = keys + count;
+  particles = particleList_p->elements;
+
+  for (i = 0; i < count; i++) {
+    keys[i] = calculateSortKey(particles[i], isMortonOrder);
+  }
+
+  for (shift = 0; shift < 64; shift += RADIX_BITS) {
+    memset(offsets, 0, sizeof(offsets));
+    for (i = 0; i < count; i++) {
+      offsets[(keys[i] >> shift) & (RADIX_SIZE - 1)]++;
+    }
+    if (offsets[(keys[0] >> shift) & (RADIX_SIZE - 1)] == count) {
+      continue;
+    }
+
+    total = 0;
+    for (digit = 0; digit < RADIX_SIZE; digit++) {
+      i = offsets[digit];
+      offsets[digit] = total;
+      total += i;
+    }
+    for (i = 0; i < count; i++) {
+      digit = (keys[i] >> shift) & (RADIX_SIZE - 1);
+      sortedKeys[offsets[digit]] = keys[i];
+      sortedParticles[offsets[digit]++] = particles[i];
+    }
+
+    swapKeys = keys;
+    keys = sortedKeys;
+    sortedKeys = swapKeys;
+    swapParticles = particles;
+    particles = sortedParticles;
+    sortedParticles = swapParticles;
+  }
+
+  /* After an odd number of passes the sorted particles are in the scratch
+   * array, which becomes the list's array */
+  particleList_p->elements = particles;
+  free(sortedParticles);
+  free(keys < sortedKeys ? keys : sortedKeys);
+
+}
@@ -0,0 +1,26 @@
+/**
+ * HPCU Bi-Weekly Challenge: Distributed Ideal Gas
+ * MPI version
+ * Ordering - defines a function for sorting particles by the cells they are
+ * in, so that consecutive particles touch nearby cells.
+ *
+ * @author Aaron Weeden, Shodor Education Foundation
+ * @version 3.1
+ * @since 3.1
+ */
+#ifndef ORDERING_H
+#define ORDERING_H
+
+#include "typedefs.h"
+
+/**
+ * Sort a list of particles by flask, then by cell, in either row-major order
+ * or Morton (Z) order.
+ *
+ * @param particleList_p pointer to the list of particles to sort
+ * @param isMortonOrder true for Morton order, false for row-major order
+ */
+void sortParticles(particle_list_type *particleList_p,
+    const bool isMortonOrder);
+
+#endif
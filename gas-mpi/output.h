@@ -1,7 +1,7 @@
 /**
  * HPCU Bi-Weekly Challenge: Distributed Ideal Gas
  * MPI version
- * Output - Defines functions for drawing simulation data in ASCII.
+ * Output - Defines functions for printing simulation data.
  *
  * @author Aaron Weeden, Shodor Education Foundation
  * @version 3.0
@@ -10,29 +10,34 @@
 #ifndef OUTPUT_H
 #define OUTPUT_H
 
+#include <stdio.h>
 #include "typedefs.h"
 
-/**
- * Prints an ASCII picture of the given time step.
- *
- * @param timeIdx ID of the current time step
- * @param flask1 the first flask
- * @param flask2 the second flask
- */
-void printPicture(const int timeIdx, const flask_type flask1,
-    const flask_type flask2);
-
 /**
  * Calculates simulation properties related to number of particles and volume,
  * and prints them.  Also returns the ratio of two ratios: the number of
  * particles in flask 1 to the number of particles in flask 2, and the
  * volume of flask 1 to the volume of flask 2.
  *
- * @param particles list of particles
+ * @param n1 number of particles in flask 1
+ * @param n2 number of particles in flask 2
  * @param vratio ratio of volume of flask 1 to volume of flask 2
  * @return the ratio of ratios
  */
-double calculateAndPrintSimulationProperties(particle_list_type particleList,
+double calculateAndPrintSimulationProperties(const long n1, const long n2,
     const double vratio);
 
+/**
+ * Writes a line of statistics for a time step to a file: the time step, the
+ * number of particles in each flask and the ratio of ratios.
+ *
+ * @param file the file
+ * @param timeIdx ID of the time step
+ * @param n1 number of particles in flask 1
+ * @param n2 number of particles in flask 2
+ * @param ratio the ratio of ratios
+ */
+void printStatistics(FILE *file, const int timeIdx, const long n1,
+    const long n2, const double ratio);
+
 #endif
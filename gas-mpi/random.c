@@ -1,24 +1,241 @@
 /**
  * HPCU Bi-Weekly Challenge: Distributed Ideal Gas
  * MPI version
- * Random - Defines a function for getting a random integer
+ * Random - Defines functions for getting random numbers
  *
  * @author Aaron Weeden, Shodor Education Foundation
- * @version 3.0
+ * @version 3.1
  * @since 1.0
  */
-#include <stdlib.h>
+#include <stdint.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 #include "random.h"
 
+/**
+ * Number of 32-bit random numbers generated at a time into each thread's
+ * buffer.  Must be even.
+ */
+#define RANDOM_BUFFER_SIZE 256
+
+/**
+ * State of a thread's stream and its buffer of generated numbers.
+ */
+typedef struct {
+  uint64_t state[4];
+  uint32_t buffer[RANDOM_BUFFER_SIZE];
+  int position;
+} random_stream_type;
+
+static random_stream_type stream;
+#pragma omp threadprivate(stream)
+
+/**
+ * Jump polynomials that advance xoshiro256** by 2^128 and 2^192 numbers.
+ */
+static const uint64_t JUMP[4] = {
+  0x180ec6d33cfd0abaull, 0xd5a61266f0c9392cull,
+  0xa9582618e03fc9aaull, 0x39abdc4529b1661cull
+};
+static const uint64_t LONG_JUMP[4] = {
+  0x76e15d3efefdcbbfull, 0xc5004e441c522fb3ull,
+  0x77710069854ee241ull, 0x39109bb02acbe635ull
+};
+
+/**
+ * Return the next value of a SplitMix64 sequence, used to turn one seed into
+ * a full xoshiro256** state.
+ *
+ * @param x_p pointer to the SplitMix64 state
+ * @return the next value
+ */
+static uint64_t splitMix64(uint64_t *x_p) {
+
+  uint64_t z = ((*x_p) += 0x9E3779B97F4A7C15ull);
+
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+  return z ^ (z >> 31);
+
+}
+
+/**
+ * Rotate a 64-bit value left.
+ *
+ * @param x the value
+ * @param k the number of bits, between 1 and 63
+ * @return the rotated value
+ */
+static inline uint64_t rotateLeft(const uint64_t x, const int k) {
+
+  return (x << k) | (x >> (64 - k));
+
+}
+
+/**
+ * Return the next number of a xoshiro256** stream.
+ *
+ * @param state the stream's state
+ * @return the next number
+ */
+static inline uint64_t nextRandom(uint64_t state[4]) {
+
+  const uint64_t result = rotateLeft(state[1] * 5, 7) * 9;
+  const uint64_t t = state[1] << 17;
+
+  state[2] ^= state[0];
+  state[3] ^= state[1];
+  state[1] ^= state[2];
+  state[0] ^= state[3];
+  state[2] ^= t;
+  state[3] = rotateLeft(state[3], 45);
+
+  return result;
+
+}
+
+/**
+ * Advance a xoshiro256** stream by the amount given by a jump polynomial.
+ *
+ * @param state the stream's state
+ * @param polynomial the jump polynomial
+ */
+static void jump(uint64_t state[4], const uint64_t polynomial[4]) {
+
+  uint64_t jumped[4] = { 0, 0, 0, 0 };
+  int i, b, j;
+
+  for (i = 0; i < 4; i++) {
+    for (b = 0; b < 64; b++) {
+      if (polynomial[i] & ((uint64_t)1 << b)) {
+        for (j = 0; j < 4; j++) {
+          jumped[j] ^= state[j];
+        }
+      }
+      nextRandom(state);
+    }
+  }
+
+  for (j = 0; j < 4; j++) {
+    state[j] = jumped[j];
+  }
+
+}
+
+/**
+ * Refill the calling thread's buffer, two 32-bit numbers per 64-bit number.
+ */
+static void refillBuffer(void) {
+
+  uint64_t x;
+  int i;
+
+  for (i = 0; i < RANDOM_BUFFER_SIZE; i += 2) {
+    x = nextRandom(stream.state);
+    stream.buffer[i] = (uint32_t)x;
+    stream.buffer[i+1] = (uint32_t)(x >> 32);
+  }
+  stream.position = 0;
+
+}
+
+/**
+ * Return the next 32-bit number from the calling thread's buffer.
+ *
+ * @return the number
+ */
+static inline uint32_t nextRandom32(void) {
+
+  if (stream.position == RANDOM_BUFFER_SIZE) {
+    refillBuffer();
+  }
+  return stream.buffer[stream.position++];
+
+}
+
+/**
+ * Seed the random number generator of every OpenMP thread of this process.
+ * Must be called outside of a parallel region, with the same seed on every
+ * process.
+ *
+ * @param seed the seed shared by all the processes
+ * @param rank the rank of this process
+ */
+void seedRandom(const unsigned int seed, const int rank) {
+
+  uint64_t processState[4];
+  uint64_t x = seed;
+  int i;
+
+  for (i = 0; i < 4; i++) {
+    processState[i] = splitMix64(&x);
+  }
+  for (i = 0; i < rank; i++) {
+    jump(processState, LONG_JUMP);
+  }
+
+#pragma omp parallel private(i)
+  {
+    int threadIdx = 0;
+
+#ifdef _OPENMP
+    threadIdx = omp_get_thread_num();
+#endif
+    for (i = 0; i < 4; i++) {
+      stream.state[i] = processState[i];
+    }
+    for (i = 0; i < threadIdx; i++) {
+      jump(stream.state, JUMP);
+    }
+    stream.position = RANDOM_BUFFER_SIZE;
+  }
+
+}
+
 /**
  * Return a random integer between 0 (inclusive) and a maximum value
- * (exclusive).
+ * (exclusive), using the calling thread's stream.  Every value is equally
+ * likely.
  *
- * @param max the maximum value
+ * Uses Lemire's multiply-and-shift ("Fast Random Integer Generation in an
+ * Interval", 2019): the high half of a 32-bit number times max is in range,
+ * and the rare numbers whose low half falls below 2^32 mod max are redrawn
+ * to remove the bias.
+ *
+ * @param max the maximum value, which must be positive
  * @return the random integer
 */
 int randomInt(int max) {
 
-  return max * random() / RAND_MAX;
+  const uint32_t range = (uint32_t)max;
+  uint64_t product = (uint64_t)nextRandom32() * range;
+  uint32_t threshold;
+
+  if ((uint32_t)product < range) {
+    threshold = (uint32_t)(-range) % range;
+    while ((uint32_t)product < threshold) {
+      product = (uint64_t)nextRandom32() * range;
+    }
+  }
+
+  return (int)(product >> 32);
+
+}
+
+/**
+ * Return a random number between 0 (inclusive) and 1 (exclusive) that
+ * depends only on a seed and an index, so it is the same whichever process
+ * or thread asks for it.  Uses the SplitMix64 finalizer.
+ *
+ * @param seed the seed
+ * @param index the index
+ * @return the random number
+ */
+double randomUniformAt(const unsigned int seed, const long index) {
+
+  uint64_t x = ((uint64_t)seed << 32) ^ (uint64_t)index;
+
+  return (double)(splitMix64(&x) >> 11) / 9007199254740992.0;
 
 }
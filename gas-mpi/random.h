@@ -1,22 +1,51 @@
 /**
  * HPCU Bi-Weekly Challenge: Distributed Ideal Gas
  * MPI version
- * Random - Defines a function for getting a random integer
+ * Random - Defines functions for getting random numbers
+ *
+ * Every OpenMP thread of every process draws from its own stream of the
+ * xoshiro256** generator (Blackman and Vigna, "Scrambled Linear Pseudorandom
+ * Number Generators", 2021).  The streams are the same sequence started
+ * 2^192 numbers apart for each rank and 2^128 apart for each thread, so they
+ * never overlap and no locking is needed.  Numbers are generated in batches
+ * into a per-thread buffer.
  *
  * @author Aaron Weeden, Shodor Education Foundation
- * @version 3.0
+ * @version 3.1
  * @since 1.0
  */
 #ifndef RANDOM_H
 #define RANDOM_H
 
+/**
+ * Seed the random number generator of every OpenMP thread of this process.
+ * Must be called outside of a parallel region, with the same seed on every
+ * process.
+ *
+ * @param seed the seed shared by all the processes
+ * @param rank the rank of this process
+ */
+void seedRandom(const unsigned int seed, const int rank);
+
 /**
  * Return a random integer between 0 (inclusive) and a maximum value
- * (exclusive).
+ * (exclusive), using the calling thread's stream.  Every value is equally
+ * likely.
  *
- * @param max the maximum value
+ * @param max the maximum value, which must be positive
  * @return the random integer
 */
 int randomInt(int max);
 
+/**
+ * Return a random number between 0 (inclusive) and 1 (exclusive) that
+ * depends only on a seed and an index, so it is the same whichever process
+ * or thread asks for it.
+ *
+ * @param seed the seed
+ * @param index the index
+ * @return the random number
+ */
+double randomUniformAt(const unsigned int seed, const long index);
+
 #endif
@@ -7,16 +7,113 @@
  * @version 3.0
  * @since 1.0
  */
+#include <mpi.h>
+#include <math.h>
+#include <stdlib.h>
 #include "typedefs.h"
 #include "output.h"
 #include "movement.h"
+#include "ordering.h"
+#include "snapshot.h"
 #include "simulation.h"
 
+/**
+ * Ratios of ratios over the most recent time steps, used to decide whether
+ * the flasks are at equilibrium.
+ */
+typedef struct {
+  double *ratios;
+  int count;
+  int stepCount;
+  double finiteSum;
+  int infiniteCount;
+} ratio_window_type;
+
+/**
+ * Calculate the ratio of ratios from the flasks' particle counts, adding up
+ * the counts of every process if the flasks are decomposed, and write the
+ * statistics for the time step if there is a file for them.
+ *
+ * @param flask1 the first flask
+ * @param flask2 the second flask
+ * @param vratio ratio of volume of flask 1 to volume of flask 2
+ * @param domain_p pointer to this process's block of the flasks, or NULL
+ * @param statisticsFile file for the statistics, or NULL
+ * @param timeIdx ID of the time step
+ * @return the ratio of ratios
+ */
+static double calculateRatio(const flask_type flask1, const flask_type flask2,
+    const double vratio, const domain_type *domain_p, FILE *statisticsFile,
+    const int timeIdx) {
+
+  long counts[2];
+  double ratio;
+
+  counts[0] = flask1.particleCount;
+  counts[1] = flask2.particleCount;
+  if (domain_p != NULL) {
+    MPI_Allreduce(MPI_IN_PLACE, counts, 2, MPI_LONG, MPI_SUM, MPI_COMM_WORLD);
+  }
+
+  ratio = calculateAndPrintSimulationProperties(counts[0], counts[1], vratio);
+  if (statisticsFile != NULL) {
+    printStatistics(statisticsFile, timeIdx, counts[0], counts[1], ratio);
+  }
+
+  return ratio;
+
+}
+
+/**
+ * Add a ratio of ratios to the window, replacing the oldest, and return
+ * whether the mean of the window is within a tolerance of 1.  Ratios are
+ * infinite while flask 2 is empty, and a window holding any of them is never
+ * at equilibrium.
+ *
+ * @param window_p pointer to the window
+ * @param ratio the ratio of ratios
+ * @param tolerance the tolerance
+ * @return true if the window is full and its mean is within the tolerance
+ */
+static bool isAtEquilibrium(ratio_window_type *window_p, const double ratio,
+    const double tolerance) {
+
+  const int slot = window_p->stepCount % window_p->count;
+
+  if (window_p->stepCount >= window_p->count) {
+    if (isinf(window_p->ratios[slot])) {
+      window_p->infiniteCount--;
+    }
+    else {
+      window_p->finiteSum -= window_p->ratios[slot];
+    }
+  }
+
+  window_p->ratios[slot] = ratio;
+  if (isinf(ratio)) {
+    window_p->infiniteCount++;
+  }
+  else {
+    window_p->finiteSum += ratio;
+  }
+  window_p->stepCount++;
+
+  return window_p->stepCount >= window_p->count &&
+    window_p->infiniteCount == 0 &&
+    fabs(window_p->finiteSum / window_p->count - 1.0) <= tolerance;
+
+}
+
 /**
  * Run a simulation of particles moving randomly in 2 flasks connected by
- * stopcocks for a given number of time steps.  Return a final ratio of two
- * ratios: the number of particles in flask 1 to the number of particles in
- *   flask 2, and the volume of flask 1 to the volume of flask 2.
+ * stopcocks for a given number of time steps, or until the flasks reach
+ * equilibrium.  Return a final ratio of two ratios: the number of particles
+ * in flask 1 to the number of particles in flask 2, and the volume of flask 1
+ * to the volume of flask 2.
+ *
+ * The numbers of particles come from the flasks' counts, which are kept up
+ * to date as particles move, so the ratio only needs to be calculated when
+ * it is written out, checked for equilibrium, or returned.
  *
  * @param flask1_p pointer to the first flask, which must be previously
  *   initialized
@@ -24,26 +121,76 @@
  *   initialized
  * @param particleList_p pointer to the list of particles, which must be
  *   previously initialized
- * @param timeCount number of time steps for which to run the simulation
+ * @param config the number of time steps, how often to sort the particles
+ *   and take pictures, and the equilibrium criterion
  * @param vratio ratio of volume of flask 1 to volume of flask 2
+ * @param domain_p pointer to this process's block of the flasks, or NULL if
+ *   the process simulates the whole flasks on its own
+ * @param statisticsFile file to which to write the statistics for every time
+ *   step, or NULL
+ * @param snapshots_p pointer to the writer of pictures of the flasks, which
+ *   are taken every few time steps and at the end, or NULL
+ * @param timeCount_p pointer to the number of time steps actually run
  * @return the final ratio
  */
 double simulate(flask_type *flask1_p, flask_type *flask2_p,
-    particle_list_type *particleList_p, const int timeCount,
-    const double vratio) {
+    particle_list_type *particleList_p, const config_type config,
+    const double vratio, domain_type *domain_p, FILE *statisticsFile,
+    snapshot_writer_type *snapshots_p, int *timeCount_p) {
 
+  /* Only rank 0 has the statistics file, but every process must take part
+   * in calculating the ratio */
+  const bool isTracking =
+    (config.statisticsPath != NULL || config.tolerance > 0.0);
+  ratio_window_type window;
+  bool isDone = false;
   int timeIdx;
   double ratio;
 
-  for (timeIdx = 0; timeIdx < timeCount; timeIdx++) {
-    /* Commented out for version 2.0 */
-    /*printPicture(timeIdx, (*flask1_p), (*flask2_p));*/
+  window.ratios = NULL;
+  if (config.tolerance > 0.0) {
+    window.count = config.windowCount;
+    window.stepCount = 0;
+    window.finiteSum = 0.0;
+    window.infiniteCount = 0;
+    window.ratios = (double*)malloc(window.count * sizeof(double));
+    if (window.ratios == NULL) {
+      fprintf(stderr, "Could not allocate the ratio window, exiting!\n");
+      exit(EXIT_FAILURE);
+    }
+  }
+
+  ratio = calculateRatio((*flask1_p), (*flask2_p), vratio, domain_p,
+    statisticsFile, 0);
+
+  for (timeIdx = 0; timeIdx < config.timeCount && !isDone; timeIdx++) {
+    if (snapshots_p != NULL && timeIdx % config.snapshotInterval == 0) {
+      takeSnapshot(snapshots_p, timeIdx, (*flask1_p), (*flask2_p));
+    }
 
-    ratio = calculateAndPrintSimulationProperties((*particleList_p), vratio);
+    if (config.sortInterval > 0 && timeIdx % config.sortInterval == 0) {
+      sortParticles(particleList_p, config.isMortonOrder);
+    }
 
-    moveParticlesRandomly(particleList_p, flask1_p, flask2_p);
+    moveParticlesRandomly(particleList_p, flask1_p, flask2_p, domain_p,
+      config.seed, timeIdx);
+
+    if (isTracking || timeIdx == config.timeCount - 1) {
+      ratio = calculateRatio((*flask1_p), (*flask2_p), vratio, domain_p,
+        statisticsFile, timeIdx + 1);
+      if (config.tolerance > 0.0) {
+        isDone = isAtEquilibrium(&window, ratio, config.tolerance);
+      }
+    }
+  }
+
+  if (snapshots_p != NULL) {
+    takeSnapshot(snapshots_p, timeIdx, (*flask1_p), (*flask2_p));
   }
 
+  free(window.ratios);
+  (*timeCount_p) = timeIdx;
+
   return ratio;
 
 }
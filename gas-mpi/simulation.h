@@ -10,13 +10,15 @@
 #ifndef SIMULATION_H
 #define SIMULATION_H
 
+#include <stdio.h>
 #include "typedefs.h"
 
 /**
  * Run a simulation of particles moving randomly in 2 flasks connected by
- * stopcocks for a given number of time steps.  Return a final ratio of two
- * ratios: the number of particles in flask 1 to the number of particles in
- *   flask 2, and the volume of flask 1 to the volume of flask 2.
+ * stopcocks for a given number of time steps, or until the flasks reach
+ * equilibrium.  Return a final ratio of two ratios: the number of particles
+ * in flask 1 to the number of particles in flask 2, and the volume of flask 1
+ * to the volume of flask 2.
  *
  * @param flask1_p pointer to the first flask, which must be previously
  *   initialized
@@ -24,12 +26,21 @@
  *   initialized
  * @param particleList_p pointer to the list of particles, which must be
  *   previously initialized
- * @param timeCount number of time steps for which to run the simulation
+ * @param config the number of time steps, how often to sort the particles
+ *   and take pictures, and the equilibrium criterion
  * @param vratio ratio of volume of flask 1 to volume of flask 2
+ * @param domain_p pointer to this process's block of the flasks, or NULL if
+ *   the process simulates the whole flasks on its own
+ * @param statisticsFile file to which to write the statistics for every time
+ *   step, or NULL
+ * @param snapshots_p pointer to the writer of pictures of the flasks, which
+ *   are taken every few time steps and at the end, or NULL
+ * @param timeCount_p pointer to the number of time steps actually run
  * @return the final ratio
  */
 double simulate(flask_type *flask1_p, flask_type *flask2_p,
-    particle_list_type *particleList_p, const int timeCount,
-    const double vratio);
+    particle_list_type *particleList_p, const config_type config,
+    const double vratio, domain_type *domain_p, FILE *statisticsFile,
+    snapshot_writer_type *snapshots_p, int *timeCount_p);
 
 #endif
@@ -0,0 +1,432 @@
+/**
+ * HPCU Bi-Weekly Challenge: Distributed Ideal Gas
+ * MPI version
+ * Snapshot - defines functions for writing pictures of the flasks to a file
+ * every few time steps without holding up the simulation.
+ *
+ * @author Aaron Weeden, Shodor Education Foundation
+ * @version 3.1
+ * @since 3.1
+ */
+#include <mpi.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "constants.h"
+#include "snapshot.h"
+
+/**
+ * Allocate memory, exiting if it cannot be.
+ *
+ * @param size the number of bytes
+ * @param name what the memory is for, for the error message
+ * @return the memory
+ */
+static char *allocateBytes(const size_t size, const char *name) {
+
+  char *bytes = (char*)malloc(size > 0 ? size : 1);
+
+  if (bytes == NULL) {
+    fprintf(stderr, "Could not allocate the %s, exiting!\n", name);
+    exit(EXIT_FAILURE);
+  }
+
+  return bytes;
+
+}
+
+/**
+ * Render one line of an ASCII picture: a row of both flasks and the wall or
+ * stopcock between them.  The line below the last row of a flask draws its
+ * bottom wall, and the line below both draws the bottom corner between them.
+ *
+ * @param line the line, which must hold both flasks' columns plus 4 bytes
+ * @param rowIdx ID of the row
+ * @param flask1 the first flask
+ * @param flask2 the second flask
+ */
+static void renderAsciiLine(char *line, const int rowIdx,
+    const flask_type flask1, const flask_type flask2) {
+
+  const int columnCount1 = flask1.columnCount;
+  const int columnCount2 = flask2.columnCount;
+  int columnIdx;
+
+  /* Left wall and flask 1, or its bottom wall, or empty space */
+  if (rowIdx < flask1.rowCount) {
+    line[0] = '|';
+    for (columnIdx = 0; columnIdx < columnCount1; columnIdx++) {
+      line[1 + columnIdx] =
+        (FLASK_CELL(flask1, rowIdx, columnIdx) == EMPTY) ? ' ' : 'o';
+    }
+  }
+  else {
+    line[0] = (rowIdx == flask1.rowCount) ? '\\' : ' ';
+    memset(line + 1, (rowIdx == flask1.rowCount) ? '-' : ' ', columnCount1);
+  }
+
+  /* Stopcock, wall between flasks, or bottom corner between them; if both
+   * stopcocks are in this row, either one's particle is drawn */
+  if (rowIdx == flask1.stopcockRow || rowIdx == flask2.stopcockRow) {
+    line[1 + columnCount1] =
+      ((rowIdx == flask1.stopcockRow && flask1.stopcockCell != EMPTY) ||
+       (rowIdx == flask2.stopcockRow && flask2.stopcockCell != EMPTY)) ?
+      'o' : ' ';
+  }
+  else if (rowIdx < flask1.rowCount || rowIdx < flask2.rowCount) {
+    line[1 + columnCount1] = '|';
+  }
+  else if (flask1.rowCount == flask2.rowCount) {
+    line[1 + columnCount1] = '+';
+  }
+  else {
+    line[1 + columnCount1] = (flask1.rowCount < flask2.rowCount) ? '\\' : '/';
+  }
+
+  /* Flask 2 and right wall, or its bottom wall, or empty space */
+  if (rowIdx < flask2.rowCount) {
+    for (columnIdx = 0; columnIdx < columnCount2; columnIdx++) {
+      line[2 + columnCount1 + columnIdx] =
+        (FLASK_CELL(flask2, rowIdx, columnIdx) == EMPTY) ? ' ' : 'o';
+    }
+    line[2 + columnCount1 + columnCount2] = '|';
+  }
+  else {
+    memset(line + 2 + columnCount1, (rowIdx == flask2.rowCount) ? '-' : ' ',
+      columnCount2);
+    line[2 + columnCount1 + columnCount2] =
+      (rowIdx == flask2.rowCount) ? '/' : ' ';
+  }
+
+  line[3 + columnCount1 + columnCount2] = '\n';
+
+}
+
+/**
+ * Render one line of a binary picture: one bit per cell of a row of flask 1,
+ * of the stopcock in that row, and of the row of flask 2.
+ *
+ * @param line the line
+ * @param rowSize the number of bytes in the line
+ * @param rowIdx ID of the row
+ * @param flask1 the first flask
+ * @param flask2 the second flask
+ */
+static void renderBinaryLine(unsigned char *line, const size_t rowSize,
+    const int rowIdx, const flask_type flask1, const flask_type flask2) {
+
+  const int stopcockBit = flask1.columnCount;
+  int columnIdx, bit;
+
+  memset(line, 0, rowSize);
+
+  if (rowIdx < flask1.rowCount) {
+    for (columnIdx = 0; columnIdx < flask1.columnCount; columnIdx++) {
+      if (FLASK_CELL(flask1, rowIdx, columnIdx) != EMPTY) {
+        line[columnIdx >> 3] |= (unsigned char)(1u << (columnIdx & 7));
+      }
+    }
+  }
+
+  if ((rowIdx == flask1.stopcockRow && flask1.stopcockCell != EMPTY) ||
+      (rowIdx == flask2.stopcockRow && flask2.stopcockCell != EMPTY)) {
+    line[stopcockBit >> 3] |= (unsigned char)(1u << (stopcockBit & 7));
+  }
+
+  if (rowIdx < flask2.rowCount) {
+    for (columnIdx = 0; columnIdx < flask2.columnCount; columnIdx++) {
+      if (FLASK_CELL(flask2, rowIdx, columnIdx) != EMPTY) {
+        bit = stopcockBit + 1 + columnIdx;
+        line[bit >> 3] |= (unsigned char)(1u << (bit & 7));
+      }
+    }
+  }
+
+}
+
+/**
+ * Write the frames handed over by takeSnapshot() until finishSnapshots()
+ * says there are no more.
+ *
+ * @param argument pointer to the writer
+ * @return NULL
+ */
+static void *writeFrames(void *argument) {
+
+  snapshot_writer_type *writer_p = (snapshot_writer_type*)argument;
+  const char *frame;
+  size_t frameSize;
+
+  pthread_mutex_lock(&(writer_p->mutex));
+  while (true) {
+    while (writer_p->pending == NULL && !writer_p->isFinished) {
+      pthread_cond_wait(&(writer_p->condition), &(writer_p->mutex));
+    }
+    if (writer_p->pending == NULL) {
+      break;
+    }
+    frame = writer_p->pending;
+    frameSize = writer_p->pendingSize;
+
+    /* Write without the lock, so the next frame can be rendered meanwhile */
+    pthread_mutex_unlock(&(writer_p->mutex));
+    if (fwrite(frame, 1, frameSize, writer_p->file) != frameSize) {
+      fprintf(stderr, "Could not write a snapshot, exiting!\n");
+      exit(EXIT_FAILURE);
+    }
+    pthread_mutex_lock(&(writer_p->mutex));
+
+    writer_p->pending = NULL;
+    pthread_cond_broadcast(&(writer_p->condition));
+  }
+  pthread_mutex_unlock(&(writer_p->mutex));
+
+  return NULL;
+
+}
+
+/**
+ * Allocate the frame buffers, open the file and start the writing thread on
+ * rank 0.  In a decomposed simulation every process must call this.
+ *
+ * @param writer_p pointer to the writer to initialize
+ * @param config the flask sizes, the path of the file and the format
+ * @param domain_p pointer to this process's block of the flasks, or NULL if
+ *   the process simulates the whole flasks on its own
+ * @param rank the rank of this process
+ */
+void initializeSnapshots(snapshot_writer_type *writer_p,
+    const config_type config, const domain_type *domain_p, const int rank) {
+
+  const int columnCount = config.flask1ColumnCount + config.flask2ColumnCount;
+  int header[6];
+  int processCount, processIdx, bufferIdx;
+  char *edges;
+
+  writer_p->isWriter = (rank == 0);
+  writer_p->isBinary = config.isBinarySnapshot;
+  writer_p->isDecomposed = (domain_p != NULL);
+  writer_p->rowCount = (config.flask1RowCount > config.flask2RowCount) ?
+    config.flask1RowCount : config.flask2RowCount;
+  writer_p->firstRowIdx = (domain_p != NULL) ? domain_p->firstRowIdx : 0;
+  writer_p->endRowIdx =
+    (domain_p != NULL) ? domain_p->endRowIdx : writer_p->rowCount;
+  writer_p->rowSize = writer_p->isBinary ?
+    (size_t)(columnCount + 8) / 8 : (size_t)columnCount + 4;
+  writer_p->edgeSize = writer_p->isBinary ? 0 : writer_p->rowSize;
+  writer_p->headerCapacity = SNAPSHOT_HEADER_CAPACITY;
+  writer_p->frameSize = 2 * writer_p->edgeSize +
+    (size_t)writer_p->rowCount * writer_p->rowSize;
+  writer_p->buffers[0] = NULL;
+  writer_p->buffers[1] = NULL;
+  writer_p->fillIdx = 0;
+  writer_p->rowBuffer = NULL;
+  writer_p->counts = NULL;
+  writer_p->displacements = NULL;
+  writer_p->file = NULL;
+  writer_p->pending = NULL;
+  writer_p->pendingSize = 0;
+  writer_p->isFinished = false;
+
+  /* MPI counts the bytes gathered from each process with an int */
+  if (writer_p->isDecomposed &&
+      (size_t)writer_p->rowCount * writer_p->rowSize > INT_MAX) {
+    if (writer_p->isWriter) {
+      fprintf(stderr, "Snapshots of flasks this large cannot be gathered, "
+        "exiting!\n");
+    }
+    MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+  }
+
+  if (!writer_p->isWriter) {
+    writer_p->rowBuffer = allocateBytes((size_t)(writer_p->endRowIdx -
+      writer_p->firstRowIdx) * writer_p->rowSize, "snapshot rows");
+    MPI_Gather(&(writer_p->firstRowIdx), 1, MPI_INT, NULL, 1, MPI_INT, 0,
+      MPI_COMM_WORLD);
+    return;
+  }
+
+  /* Rank 0 finds which rows each process renders */
+  if (writer_p->isDecomposed) {
+    MPI_Comm_size(MPI_COMM_WORLD, &processCount);
+    writer_p->counts = (int*)allocateBytes(2 * processCount * sizeof(int),
+      "snapshot counts");
+    writer_p->displacements = writer_p->counts + processCount;
+    MPI_Gather(&(writer_p->firstRowIdx), 1, MPI_INT, writer_p->displacements,
+      1, MPI_INT, 0, MPI_COMM_WORLD);
+    for (processIdx = 0; processIdx < processCount; processIdx++) {
+      writer_p->counts[processIdx] = (int)((processIdx + 1 < processCount ?
+        writer_p->displacements[processIdx + 1] : writer_p->rowCount) -
+        writer_p->displacements[processIdx]) * (int)writer_p->rowSize;
+      writer_p->displacements[processIdx] *= (int)writer_p->rowSize;
+    }
+  }
+
+  writer_p->file = fopen(config.snapshotPath, writer_p->isBinary ? "wb" : "w");
+  if (writer_p->file == NULL) {
+    fprintf(stderr, "Could not open %s, exiting!\n", config.snapshotPath);
+    MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+  }
+
+  if (writer_p->isBinary) {
+    header[0] = config.flask1RowCount;
+    header[1] = config.flask1ColumnCount;
+    header[2] = config.flask1StopcockRow;
+    header[3] = config.flask2RowCount;
+    header[4] = config.flask2ColumnCount;
+    header[5] = config.flask2StopcockRow;
+    fwrite(SNAPSHOT_MAGIC, 1, 4, writer_p->file);
+    fwrite(header, sizeof(int), 6, writer_p->file);
+  }
+
+  /* The top and bottom lines never change, so draw them once in each
+   * buffer */
+  for (bufferIdx = 0; bufferIdx < 2; bufferIdx++) {
+    writer_p->buffers[bufferIdx] = allocateBytes(writer_p->headerCapacity +
+      writer_p->frameSize, "snapshot buffer");
+    if (!writer_p->isBinary) {
+      edges = writer_p->buffers[bufferIdx] + writer_p->headerCapacity;
+      edges[0] = '/';
+      memset(edges + 1, '-', columnCount + 1);
+      edges[1 + config.flask1ColumnCount] = '+';
+      edges[2 + columnCount] = '\\';
+      edges[3 + columnCount] = '\n';
+      edges += writer_p->frameSize - writer_p->edgeSize;
+      memset(edges, ' ', writer_p->edgeSize);
+      if (config.flask1RowCount == writer_p->rowCount) {
+        edges[0] = '\\';
+        memset(edges + 1, '-', config.flask1ColumnCount);
+      }
+      edges[1 + config.flask1ColumnCount] =
+        (config.flask1RowCount == config.flask2RowCount) ? '+' :
+        (config.flask1RowCount < config.flask2RowCount) ? '\\' : '/';
+      if (config.flask2RowCount == writer_p->rowCount) {
+        memset(edges + 2 + config.flask1ColumnCount, '-',
+          config.flask2ColumnCount);
+        edges[2 + columnCount] = '/';
+      }
+      edges[3 + columnCount] = '\n';
+    }
+  }
+
+  pthread_mutex_init(&(writer_p->mutex), NULL);
+  pthread_cond_init(&(writer_p->condition), NULL);
+  if (pthread_create(&(writer_p->thread), NULL, writeFrames, writer_p) != 0) {
+    fprintf(stderr, "Could not start the snapshot thread, exiting!\n");
+    MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+  }
+
+}
+
+/**
+ * Render a picture of the flasks and hand it to the writing thread, waiting
+ * only if the thread is still writing the picture before last.  In a
+ * decomposed simulation every process must call this.
+ *
+ * @param writer_p pointer to the writer
+ * @param timeIdx ID of the current time step
+ * @param flask1 the first flask
+ * @param flask2 the second flask
+ */
+void takeSnapshot(snapshot_writer_type *writer_p, const int timeIdx,
+    const flask_type flask1, const flask_type flask2) {
+
+  const size_t rowSize = writer_p->rowSize;
+  const int firstRowIdx = writer_p->firstRowIdx;
+  const int endRowIdx = writer_p->endRowIdx;
+  char header[SNAPSHOT_HEADER_CAPACITY];
+  char *frame = NULL;
+  char *rows;
+  size_t headerSize;
+  int rowIdx;
+
+  /* The writing process renders its rows straight into the frame */
+  if (writer_p->isWriter) {
+    frame = writer_p->buffers[writer_p->fillIdx] + writer_p->headerCapacity;
+    rows = frame + writer_p->edgeSize + (size_t)firstRowIdx * rowSize;
+  }
+  else {
+    rows = writer_p->rowBuffer;
+  }
+
+  #pragma omp parallel for schedule(static)
+  for (rowIdx = firstRowIdx; rowIdx < endRowIdx; rowIdx++) {
+    if (writer_p->isBinary) {
+      renderBinaryLine((unsigned char*)rows +
+        (size_t)(rowIdx - firstRowIdx) * rowSize, rowSize, rowIdx, flask1,
+        flask2);
+    }
+    else {
+      renderAsciiLine(rows + (size_t)(rowIdx - firstRowIdx) * rowSize, rowIdx,
+        flask1, flask2);
+    }
+  }
+
+  if (writer_p->isDecomposed) {
+    MPI_Gatherv(writer_p->isWriter ? MPI_IN_PLACE : rows,
+      (int)((endRowIdx - firstRowIdx) * rowSize), MPI_BYTE,
+      writer_p->isWriter ? frame + writer_p->edgeSize : NULL,
+      writer_p->counts, writer_p->displacements, MPI_BYTE, 0,
+      MPI_COMM_WORLD);
+  }
+
+  if (!writer_p->isWriter) {
+    return;
+  }
+
+  /* Put the header just in front of the frame, so the two are written
+   * together */
+  if (writer_p->isBinary) {
+    headerSize = sizeof(int);
+    memcpy(header, &timeIdx, headerSize);
+  }
+  else {
+    headerSize = (size_t)snprintf(header, sizeof(header), "Time step: %d\n",
+      timeIdx);
+  }
+  memcpy(frame - headerSize, header, headerSize);
+
+  /* Hand the frame over once the one before it has been written, then fill
+   * the other buffer next time */
+  pthread_mutex_lock(&(writer_p->mutex));
+  while (writer_p->pending != NULL) {
+    pthread_cond_wait(&(writer_p->condition), &(writer_p->mutex));
+  }
+  writer_p->pending = frame - headerSize;
+  writer_p->pendingSize = headerSize + writer_p->frameSize;
+  pthread_cond_broadcast(&(writer_p->condition));
+  pthread_mutex_unlock(&(writer_p->mutex));
+
+  writer_p->fillIdx = 1 - writer_p->fillIdx;
+
+}
+
+/**
+ * Wait for the last picture to be written, stop the writing thread, close
+ * the file and release the buffers.
+ *
+ * @param writer_p pointer to the writer
+ */
+void finishSnapshots(snapshot_writer_type *writer_p) {
+
+  if (writer_p->isWriter) {
+    pthread_mutex_lock(&(writer_p->mutex));
+    writer_p->isFinished = true;
+    pthread_cond_broadcast(&(writer_p->condition));
+    pthread_mutex_unlock(&(writer_p->mutex));
+    pthread_join(writer_p->thread, NULL);
+    pthread_cond_destroy(&(writer_p->condition));
+    pthread_mutex_destroy(&(writer_p->mutex));
+
+    if (fclose(writer_p->file) != 0) {
+      fprintf(stderr, "Could not close the snapshot file!\n");
+    }
+  }
+
+  free(writer_p->counts);
+  free(writer_p->rowBuffer);
+  free(writer_p->buffers[1]);
+  free(writer_p->buffers[0]);
+
+}
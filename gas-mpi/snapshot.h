@@ -0,0 +1,67 @@
+/**
+ * HPCU Bi-Weekly Challenge: Distributed Ideal Gas
+ * MPI version
+ * Snapshot - defines functions for writing pictures of the flasks to a file
+ * every few time steps without holding up the simulation.
+ *
+ * Each picture is rendered into a preallocated buffer and handed to a
+ * background thread, which writes it with a single fwrite() while the
+ * simulation renders the next picture into a second buffer.  In a decomposed
+ * simulation each process renders its own rows and rank 0 gathers them.
+ *
+ * ASCII pictures are drawn the same way as by printPicture() in version 2.0,
+ * starting with a "Time step: N" line.
+ *
+ * Binary pictures are occupancy bitmaps.  The file starts with the 4 bytes
+ * "IGAS" and six ints: the rows, columns and stopcock row of flask 1 and
+ * then of flask 2.  Each picture is an int holding the time step, followed
+ * by one line for each row of the taller flask.  A line has one bit per
+ * column of flask 1, one for the stopcock in that row, and one per column of
+ * flask 2, in that order, padded to a whole number of bytes; bit j is bit
+ * (j % 8) of byte (j / 8), and is set if the cell holds a particle.  Ints are
+ * written in the byte order of the machine.
+ *
+ * @author Aaron Weeden, Shodor Education Foundation
+ * @version 3.1
+ * @since 3.1
+ */
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include "typedefs.h"
+
+/**
+ * Allocate the frame buffers, open the file and start the writing thread on
+ * rank 0.  In a decomposed simulation every process must call this.
+ *
+ * @param writer_p pointer to the writer to initialize
+ * @param config the flask sizes, the path of the file and the format
+ * @param domain_p pointer to this process's block of the flasks, or NULL if
+ *   the process simulates the whole flasks on its own
+ * @param rank the rank of this process
+ */
+void initializeSnapshots(snapshot_writer_type *writer_p,
+    const config_type config, const domain_type *domain_p, const int rank);
+
+/**
+ * Render a picture of the flasks and hand it to the writing thread, waiting
+ * only if the thread is still writing the picture before last.  In a
+ * decomposed simulation every process must call this.
+ *
+ * @param writer_p pointer to the writer
+ * @param timeIdx ID of the current time step
+ * @param flask1 the first flask
+ * @param flask2 the second flask
+ */
+void takeSnapshot(snapshot_writer_type *writer_p, const int timeIdx,
+    const flask_type flask1, const flask_type flask2);
+
+/**
+ * Wait for the last picture to be written, stop the writing thread, close
+ * the file and release the buffers.
+ *
+ * @param writer_p pointer to the writer
+ */
+void finishSnapshots(snapshot_writer_type *writer_p);
+
+#endif
@@ -0,0 +1,167 @@
+/**
+ * HPCU Bi-Weekly Challenge: Distributed Ideal Gas
+ * MPI version
+ * Ensemble test - checks that moving the particles in colour phases gives
+ * the same physics as moving them one at a time.
+ *
+ * The default flasks are run from many seeds, once with
+ * moveParticlesRandomly() and once with a serial reference that moves the
+ * particles one at a time in the order of the list, as version 3.0 did.  The
+ * test passes if the mean final ratios of the two ensembles agree to within
+ * 4 standard errors of their difference.
+ *
+ * @author Aaron Weeden, Shodor Education Foundation
+ * @version 3.1
+ * @since 3.1
+ */
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "constants.h"
+#include "typedefs.h"
+#include "initialization.h"
+#include "memory-management.h"
+#include "movement.h"
+#include "output.h"
+#include "random.h"
+
+/**
+ * Number of seeds in each ensemble.
+ */
+#define SEED_COUNT 300
+
+/**
+ * Number of standard errors by which the means may differ.
+ */
+#define ALLOWED_ERRORS 4.0
+
+/**
+ * Moves all particles in a list randomly, one at a time in the order of the
+ * list.
+ *
+ * @param particleList_p pointer to the list of particles to move randomly
+ * @param flask1_p pointer to the first flask
+ * @param flask2_p pointer to the second flask
+ */
+static void moveParticlesSerially(particle_list_type *particleList_p,
+    flask_type *flask1_p, flask_type *flask2_p) {
+
+  open_direction_list_type openDirectionList;
+  int particleIdx;
+
+  for (particleIdx = 0; particleIdx < particleList_p->count; particleIdx++) {
+    openDirectionList = calculateOpenDirections(
+      particleList_p->elements[particleIdx], (*flask1_p), (*flask2_p));
+
+    if (openDirectionList.count > 0) {
+      moveParticleInDirection(&(particleList_p->elements[particleIdx]),
+        openDirectionList.elements[randomInt(openDirectionList.count)],
+        flask1_p, flask2_p);
+    }
+  }
+
+}
+
+/**
+ * Run the default flasks for the default number of time steps from a seed,
+ * and return the final ratio.
+ *
+ * @param seed the seed
+ * @param isSerial true to move the particles with the serial reference
+ * @return the final ratio
+ */
+static double runSimulation(const unsigned int seed, const bool isSerial) {
+
+  const double vratio =
+    ((double)DEFAULT_FLASK_1_ROW_COUNT * DEFAULT_FLASK_1_COLUMN_COUNT + 1.0) /
+    ((double)DEFAULT_FLASK_2_ROW_COUNT * DEFAULT_FLASK_2_COLUMN_COUNT + 1.0);
+  const int rowCount =
+    (DEFAULT_FLASK_1_ROW_COUNT > DEFAULT_FLASK_2_ROW_COUNT) ?
+    DEFAULT_FLASK_1_ROW_COUNT : DEFAULT_FLASK_2_ROW_COUNT;
+  flask_type flask1, flask2;
+  particle_list_type particleList;
+  double ratio;
+  int timeIdx;
+
+  seedRandom(seed, 0);
+  initializeFlask(&flask1, 1, DEFAULT_FLASK_1_ROW_COUNT,
+    DEFAULT_FLASK_1_COLUMN_COUNT, DEFAULT_FLASK_1_STOPCOCK_ROW, 0, rowCount);
+  initializeFlask(&flask2, 2, DEFAULT_FLASK_2_ROW_COUNT,
+    DEFAULT_FLASK_2_COLUMN_COUNT, DEFAULT_FLASK_2_STOPCOCK_ROW, 0, rowCount);
+  initializeParticles(&particleList, &flask1,
+    DEFAULT_PARTICLE_BLOCK_ROW_COUNT, DEFAULT_PARTICLE_BLOCK_COLUMN_COUNT,
+    DEFAULT_PARTICLE_BLOCK_TOP_ROW, DEFAULT_PARTICLE_BLOCK_LEFT_COLUMN);
+
+  for (timeIdx = 0; timeIdx < DEFAULT_TIME_COUNT; timeIdx++) {
+    if (isSerial) {
+      moveParticlesSerially(&particleList, &flask1, &flask2);
+    }
+    else {
+      moveParticlesRandomly(&particleList, &flask1, &flask2, NULL, seed,
+        timeIdx);
+    }
+  }
+
+  ratio = calculateAndPrintSimulationProperties(flask1.particleCount,
+    flask2.particleCount, vratio);
+
+  freeParticles(&particleList);
+  freeFlask(&flask2);
+  freeFlask(&flask1);
+
+  return ratio;
+
+}
+
+/**
+ * Run an ensemble of simulations and calculate the mean of their final
+ * ratios and its standard error.
+ *
+ * @param isSerial true to move the particles with the serial reference
+ * @param mean_p pointer to the mean
+ * @param error_p pointer to the standard error of the mean
+ */
+static void runEnsemble(const bool isSerial, double *mean_p,
+    double *error_p) {
+
+  double ratio, sum = 0.0, sumSq = 0.0;
+  unsigned int seed;
+
+  for (seed = 1; seed <= SEED_COUNT; seed++) {
+    ratio = runSimulation(seed, isSerial);
+    sum += ratio;
+    sumSq += ratio * ratio;
+  }
+
+  (*mean_p) = sum / SEED_COUNT;
+  (*error_p) = sqrt((sumSq / SEED_COUNT - (*mean_p) * (*mean_p)) /
+    (SEED_COUNT - 1));
+
+}
+
+/**
+ * Runs the test.
+ *
+ * @return 0 if the ensembles agree, non-zero otherwise
+ */
+int main(void) {
+
+  double serialMean, serialError, phasedMean, phasedError, allowed;
+
+  runEnsemble(true, &serialMean, &serialError);
+  runEnsemble(false, &phasedMean, &phasedError);
+  allowed = ALLOWED_ERRORS *
+    sqrt(serialError * serialError + phasedError * phasedError);
+
+  printf("Serial mean ratio = %f +- %f\n", serialMean, serialError);
+  printf("Phased mean ratio = %f +- %f\n", phasedMean, phasedError);
+
+  if (!(fabs(phasedMean - serialMean) <= allowed)) {
+    printf("FAIL: the means differ by more than %f\n", allowed);
+    return EXIT_FAILURE;
+  }
+
+  printf("PASS\n");
+  return 0;
+
+}
@@ -11,6 +11,9 @@
 #define TYPEDEFS_H
 
 #include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <pthread.h>
 
 /**
  * Flask - contains row/column, stopcock, and contained particle information
@@ -42,11 +45,33 @@ typedef struct {
   int stopcockRow;
 
   /**
-   * Each cell of the flask can contain a particle; this 2D array holds those
-   * particles' unique identifiers, or EMPTY if there is no particle,
-   * positioned in the array how the cells are positioned in the flask.
+   * Index of the first row whose cells this process stores.  0 unless the
+   * flasks are decomposed across processes.
    */
-  int **cells;
+  int firstRowIdx;
+
+  /**
+   * Number of rows whose cells this process stores, starting at firstRowIdx.
+   * rowCount unless the flasks are decomposed across processes.
+   */
+  int localRowCount;
+
+  /**
+   * Each cell of the flask can contain a particle; this contiguous array holds
+   * those particles' unique identifiers, or EMPTY if there is no particle,
+   * row after row.  The local rows and columns are surrounded by a border one
+   * cell wide, so the neighbors of any cell in the flask can be read at fixed
+   * offsets without checking bounds.  The border holds WALL cells outside the
+   * flask and, above and below the local rows of a decomposed flask, copies
+   * of the neighboring processes' rows.  Index it with FLASK_CELL().
+   */
+  int *cells;
+
+  /**
+   * Distance in the cells array between vertically adjacent cells, i.e. the
+   * number of columns including the border.
+   */
+  int rowStride;
 
   /**
    * The stopcock can contain a particle; this holds that particle's unique
@@ -54,11 +79,29 @@ typedef struct {
    */
   int stopcockCell;
 
+  /**
+   * Number of particles in the flask, including its stopcock.  When the
+   * flask is decomposed across processes, only the particles in this
+   * process's rows are counted.
+   */
+  long particleCount;
+
 } flask_type;
 
+/**
+ * The cell in a given row and column of a flask, where row 0 and column 0 are
+ * the first inside the border.  Rows are numbered across the whole flask, so
+ * a decomposed flask can only be indexed from firstRowIdx-1 to
+ * firstRowIdx+localRowCount.
+ */
+#define FLASK_CELL(flask, rowIdx, columnIdx) \
+  ((flask).cells[(long)((rowIdx) - (flask).firstRowIdx + 1) * \
+    (flask).rowStride + (columnIdx) + 1])
+
 /**
  * Particle - contains information about which flask the particle is in and
- * where it is in that flask.
+ * where it is in that flask.  Kept to 16 bytes, 4 to a cache line, with the
+ * flask and stopcock packed into flag bits.
  *
  * @since 1.0
  */
@@ -69,11 +112,6 @@ typedef struct {
    */
   int id;
 
-  /**
-   * Pointer to the flask containing the particle.
-   */
-  flask_type *flask_p;
-
   /**
    * The particle's row location within its containing flask.
    */
@@ -85,12 +123,32 @@ typedef struct {
   int columnIdx;
 
   /**
-   * true if the particle is within the stopcock of its containing flask, and
-   * false otherwise.
+   * PARTICLE_IN_FLASK_2 if the particle is in the second flask, and
+   * PARTICLE_IN_STOPCOCK if it is within the stopcock of its containing
+   * flask.
    */
-  bool isInStopcock;
+  unsigned int flags;
+
 } particle_type;
 
+/**
+ * The ID of the flask containing a particle.
+ */
+#define PARTICLE_FLASK_ID(particle) \
+  (((particle).flags & PARTICLE_IN_FLASK_2) ? 2 : 1)
+
+/**
+ * Pointer to the flask containing a particle, given pointers to both flasks.
+ */
+#define PARTICLE_FLASK(particle, flask1_p, flask2_p) \
+  (((particle).flags & PARTICLE_IN_FLASK_2) ? (flask2_p) : (flask1_p))
+
+/**
+ * true if a particle is within the stopcock of its containing flask.
+ */
+#define PARTICLE_IS_IN_STOPCOCK(particle) \
+  (((particle).flags & PARTICLE_IN_STOPCOCK) != 0)
+
 /**
  * Particle list - array of particles and its count of elements.
  *
@@ -107,8 +165,289 @@ typedef struct {
    */
   int count;
 
+  /**
+   * Number of particles for which the arrays have room.
+   */
+  int capacity;
+
+  /**
+   * The phase of the current time step in which each particle moves; see
+   * moveParticlesRandomly().
+   */
+  unsigned char *phases;
+
 } particle_list_type;
 
+/**
+ * Domain - describes the block of rows of both flasks that this process owns
+ * when the flasks are decomposed across processes, and the buffers used to
+ * exchange particles with the processes that own the neighboring blocks.
+ *
+ * @since 3.1
+ */
+typedef struct {
+
+  /**
+   * Rank of this process.
+   */
+  int rank;
+
+  /**
+   * Rank of the process owning the rows above this block, or MPI_PROC_NULL.
+   */
+  int upRank;
+
+  /**
+   * Rank of the process owning the rows below this block, or MPI_PROC_NULL.
+   */
+  int downRank;
+
+  /**
+   * Index of the first row in the block.
+   */
+  int firstRowIdx;
+
+  /**
+   * Index of the row after the last row in the block.
+   */
+  int endRowIdx;
+
+  /**
+   * Indices in the particle list of the particles that have left the block
+   * during the current time step.
+   */
+  int *migrantIdxs;
+
+  /**
+   * Number of particles that have left the block during the current time
+   * step.
+   */
+  int migrantCount;
+
+  /**
+   * Number of those particles that have already been sent to their new
+   * owner.
+   */
+  int sentCount;
+
+  /**
+   * Number of particles that can fit in each of the message buffers.
+   */
+  int bufferCapacity;
+
+  /**
+   * Message buffers for particles moving up, moving down, and arriving.
+   */
+  int *sendUpBuffer;
+  int *sendDownBuffer;
+  int *receiveBuffer;
+
+} domain_type;
+
+/**
+ * Snapshot writer - renders pictures of the flasks into preallocated frame
+ * buffers and writes them to a file on a background thread, so that writing
+ * one frame overlaps with the time steps that follow it.
+ *
+ * A frame is a header, a top line, one fixed-size line per row of the taller
+ * flask, and a bottom line, so the lines of a decomposed simulation can be
+ * rendered by the processes that own them and gathered straight into place.
+ *
+ * @since 3.1
+ */
+typedef struct {
+
+  /**
+   * true if this process writes the frames, false if it only renders its
+   * rows and sends them to rank 0.
+   */
+  bool isWriter;
+
+  /**
+   * true for binary occupancy bitmaps, false for ASCII pictures.
+   */
+  bool isBinary;
+
+  /**
+   * true if the flasks are decomposed across processes and each frame is
+   * gathered from all of them.
+   */
+  bool isDecomposed;
+
+  /**
+   * Index of the first row this process renders, and of the row after the
+   * last.
+   */
+  int firstRowIdx;
+  int endRowIdx;
+
+  /**
+   * File to which the frames are written, on the writing process.
+   */
+  FILE *file;
+
+  /**
+   * Number of bytes in each row line, and number of row lines in a frame.
+   */
+  size_t rowSize;
+  int rowCount;
+
+  /**
+   * Number of bytes reserved for the header in front of the top line, and
+   * number of bytes in the top and bottom lines.
+   */
+  size_t headerCapacity;
+  size_t edgeSize;
+
+  /**
+   * Number of bytes in a frame, not counting the header.
+   */
+  size_t frameSize;
+
+  /**
+   * Two frame buffers: one is filled while the other is written.
+   */
+  char *buffers[2];
+
+  /**
+   * Index of the buffer to fill next.
+   */
+  int fillIdx;
+
+  /**
+   * Buffer for this process's rows when it is not the writer.
+   */
+  char *rowBuffer;
+
+  /**
+   * Number of bytes of rows each process sends and where they go in the
+   * frame, on the writing process of a decomposed simulation.
+   */
+  int *counts;
+  int *displacements;
+
+  /**
+   * Background thread that writes the frames, and the lock and condition
+   * that hand frames over to it.
+   */
+  pthread_t thread;
+  pthread_mutex_t mutex;
+  pthread_cond_t condition;
+
+  /**
+   * Start and length of the frame waiting to be or being written, or NULL
+   * once it has been written.
+   */
+  const char *pending;
+  size_t pendingSize;
+
+  /**
+   * true once no more frames will be handed over.
+   */
+  bool isFinished;
+
+} snapshot_writer_type;
+
+/**
+ * Config - the size and layout of the flasks and particles and the length of
+ * the simulation, as chosen on the command line.
+ *
+ * @since 3.1
+ */
+typedef struct {
+
+  /**
+   * Number of rows, number of columns and stopcock row of the first flask.
+   */
+  int flask1RowCount;
+  int flask1ColumnCount;
+  int flask1StopcockRow;
+
+  /**
+   * Number of rows, number of columns and stopcock row of the second flask.
+   */
+  int flask2RowCount;
+  int flask2ColumnCount;
+  int flask2StopcockRow;
+
+  /**
+   * Dimensions and location of the initial block of particles in the first
+   * flask, used if fillDensity is 0.
+   */
+  int blockRowCount;
+  int blockColumnCount;
+  int blockTopRow;
+  int blockLeftColumn;
+
+  /**
+   * Fraction of the cells of the first flask that initially hold a particle,
+   * chosen at random, or 0 to use the block of particles instead.
+   */
+  double fillDensity;
+
+  /**
+   * Seed for the random number generators.
+   */
+  unsigned int seed;
+
+  /**
+   * Number of time steps for which to run the simulation.
+   */
+  int timeCount;
+
+  /**
+   * Number of time steps between sorts of the particles by cell, or 0 to
+   * never sort them.
+   */
+  int sortInterval;
+
+  /**
+   * true to sort the particles in Morton (Z) order of their cells, false for
+   * row-major order.
+   */
+  bool isMortonOrder;
+
+  /**
+   * Path of a file to which to write the particle counts and ratio after
+   * every time step, or NULL.
+   */
+  char *statisticsPath;
+
+  /**
+   * The simulation stops early once the mean ratio over the last windowCount
+   * time steps is within this distance of 1, or never if it is 0.
+   */
+  double tolerance;
+
+  /**
+   * Number of time steps over which the ratio is averaged to decide whether
+   * the flasks are at equilibrium.
+   */
+  int windowCount;
+
+  /**
+   * true if the processes run one simulation together, and false if each
+   * process runs its own copy.
+   */
+  bool isDistributed;
+
+  /**
+   * Path of a file to which to write pictures of the flasks, or NULL.
+   */
+  char *snapshotPath;
+
+  /**
+   * Number of time steps between pictures.
+   */
+  int snapshotInterval;
+
+  /**
+   * true to write the pictures as binary occupancy bitmaps, false for ASCII.
+   */
+  bool isBinarySnapshot;
+
+} config_type;
+
 /**
  * Open direction list - array of directions in which a particle can move and
  * its number of elements.
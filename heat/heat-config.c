@@ -0,0 +1,107 @@
+/* PROGRAM: Simple Heat netCDF
+ * Config - the command-line options shared by heat.c and heat-mpi.c.
+ */
+
+#include <stdio.h>
+#include <errno.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "heat-config.h"
+
+/* Parse a positive int option, or exit. */
+static int parsePositive(const char *text, const char *name) {
+    char *end;
+    long value;
+
+    errno = 0;
+    value = strtol(text, &end, 10);
+    if (errno != 0 || *end != '\0' || value < 1 || value > INT_MAX) {
+        fprintf(stderr, "%s must be a positive integer, exiting!\n", name);
+        exit(EXIT_FAILURE);
+    }
+
+    return (int)value;
+}
+
+/* Parse a positive number option, or exit. */
+static double parsePositiveReal(const char *text, const char *name) {
+    char *end;
+    double value;
+
+    errno = 0;
+    value = strtod(text, &end);
+    if (errno != 0 || *end != '\0' || !(value > 0.0)) {
+        fprintf(stderr, "%s must be a positive number, exiting!\n", name);
+        exit(EXIT_FAILURE);
+    }
+
+    return value;
+}
+
+void parseConfig(heat_config_t *config, int argc, char **argv) {
+    int option;
+
+    config->nx = NX;
+    config->ny = NY;
+    config->nz = NZ;
+    config->ntime = NTIME;
+    config->fileName = FILE_NAME;
+    config->isWriting = true;
+    config->outputInterval = 1;
+    config->deflateLevel = 0;
+    config->isAsync = true;
+    config->tolerance = 0.0;
+    config->method = METHOD_JACOBI;
+    config->methodName = "jacobi";
+    config->timeBlock = 1;
+
+    while ((option = getopt(argc, argv, "x:y:z:t:o:nw:d:Se:m:T:")) != -1) {
+        switch (option) {
+            case 'x': config->nx = parsePositive(optarg, "NX"); break;
+            case 'y': config->ny = parsePositive(optarg, "NY"); break;
+            case 'z': config->nz = parsePositive(optarg, "NZ"); break;
+            case 't': config->ntime = parsePositive(optarg, "NTIME"); break;
+            case 'o': config->fileName = optarg; break;
+            case 'n': config->isWriting = false; break;
+            case 'w':
+                config->outputInterval = parsePositive(optarg, "N");
+                break;
+            case 'd':
+                config->deflateLevel = parsePositive(optarg, "LEVEL");
+                if (config->deflateLevel > 9) {
+                    fprintf(stderr, "LEVEL must be from 1 to 9, exiting!\n");
+                    exit(EXIT_FAILURE);
+                }
+                break;
+            case 'S': config->isAsync = false; break;
+            case 'e':
+                config->tolerance = parsePositiveReal(optarg, "TOL");
+                break;
+            case 'm':
+                if (strcmp(optarg, "jacobi") == 0)
+                    config->method = METHOD_JACOBI;
+                else if (strcmp(optarg, "sor") == 0)
+                    config->method = METHOD_SOR;
+                else if (strcmp(optarg, "multigrid") == 0)
+                    config->method = METHOD_MULTIGRID;
+                else {
+                    fprintf(stderr, "METHOD must be jacobi, sor or "
+                            "multigrid, exiting!\n");
+                    exit(EXIT_FAILURE);
+                }
+                config->methodName = optarg;
+                break;
+            case 'T':
+                config->timeBlock = parsePositive(optarg, "STEPS");
+                break;
+            default:
+                fprintf(stderr, "Usage: %s [-x NX] [-y NY] [-z NZ] "
+                        "[-t NTIME] [-o FILE] [-n] [-w N] [-d LEVEL] [-S] "
+                        "[-e TOL] [-m METHOD] [-T STEPS]\n",
+                        argv[0]);
+                exit(EXIT_FAILURE);
+        }
+    }
+}
@@ -0,0 +1,74 @@
+/* PROGRAM: Simple Heat netCDF
+ * Config - the command-line options shared by heat.c and heat-mpi.c.
+ *
+ * Options:
+ *   -x NX      number of columns (default 3)
+ *   -y NY      number of rows (default 3)
+ *   -z NZ      depth (default 3)
+ *   -t NTIME   number of time steps (default 3)
+ *   -o FILE    name of the data file (default heat-data.nc)
+ *   -n         do not write a data file; only time the time steps
+ *   -w N       write the temperatures every N time steps (default 1)
+ *   -d LEVEL   compress the temperatures with deflate, at LEVEL 1 to 9
+ *   -S         write synchronously, without the I/O thread, to compare
+ *   -e TOL     stop before NTIME time steps once no temperature changes by
+ *              TOL or more in a time step (default 0: never stop early)
+ *   -m METHOD  jacobi (default) takes time steps; sor and multigrid solve
+ *              for the steady state, by red-black SOR sweeps or multigrid
+ *              V-cycles (see heat-steady.h), which then stand in for the
+ *              time steps in -t, -w and -e.  heat-mpi only takes jacobi.
+ *   -T STEPS   take up to STEPS time steps at a time with temporal blocking
+ *              (see heat-stencil.h; default 1, no blocking).  Blocks end at
+ *              each write, and the residual is that of the last step of a
+ *              block.  Only heat, and only -m jacobi, takes more than 1.
+ */
+#ifndef HEAT_CONFIG_H
+#define HEAT_CONFIG_H
+
+#include <stdbool.h>
+
+/* This is the name of the data file we will create. */
+#define FILE_NAME "heat-data.nc"
+
+/* By default we simulate a 3 x 3 x 3 x-y-z grid for 3 timesteps. */
+#define NTIME 3
+#define NX 3
+#define NY 3
+#define NZ 3
+
+/* Values of heat_config_t.method. */
+#define METHOD_JACOBI 0
+#define METHOD_SOR 1
+#define METHOD_MULTIGRID 2
+
+typedef struct {
+    /* Size of the grid and number of time steps. */
+    int nx, ny, nz, ntime;
+
+    /* The data file, how often to write it, and how much to compress it. */
+    const char *fileName;
+    bool isWriting;
+    int outputInterval;
+    int deflateLevel;
+
+    /* Whether an I/O thread writes the data file while the grid is
+     * updated. */
+    bool isAsync;
+
+    /* Stop once the largest change in a time step is below this, if it is
+     * more than 0. */
+    double tolerance;
+
+    /* METHOD_JACOBI, METHOD_SOR or METHOD_MULTIGRID, and its name. */
+    int method;
+    const char *methodName;
+
+    /* Most time steps to take at a time. */
+    int timeBlock;
+} heat_config_t;
+
+/* Set a config to the defaults, then apply the command-line options.  Prints
+ * the usage and exits if they are invalid. */
+void parseConfig(heat_config_t *config, int argc, char **argv);
+
+#endif
@@ -0,0 +1,99 @@
+/* PROGRAM: Simple Heat netCDF
+ * Grid - the temperatures of an NX x NY x NZ grid of points.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "heat-grid.h"
+
+static float *allocateFloats(const size_t count) {
+    void *floats = NULL;
+
+    if (posix_memalign(&floats, GRID_ALIGNMENT, count * sizeof(float)) != 0) {
+        fprintf(stderr, "Could not allocate %lu floats, exiting!\n",
+                (unsigned long)count);
+        exit(EXIT_FAILURE);
+    }
+
+    return (float*)floats;
+}
+
+int countRowFaces(const heat_grid_t *grid, const int y, const int z) {
+    const int globalY = grid->firstY + y;
+    const int globalZ = grid->firstZ + z;
+
+    return (globalY == 0) + (globalY == grid->globalNy - 1)
+        + (globalZ == 0) + (globalZ == grid->globalNz - 1);
+}
+
+void initializeGrid(heat_grid_t *grid, const int nx, const int ny,
+                    const int nz) {
+    initializeBlock(grid, nx, ny, nz, 0, 0, 0, nx, ny, nz);
+}
+
+void initializeBlock(heat_grid_t *grid, const int nx, const int ny,
+                     const int nz, const int firstX, const int firstY,
+                     const int firstZ, const int globalNx,
+                     const int globalNy, const int globalNz) {
+    const size_t floatsPerLine = GRID_ALIGNMENT / sizeof(float);
+    int x, y, z, faces, neighborCount, globalX;
+
+    grid->nx = nx;
+    grid->ny = ny;
+    grid->nz = nz;
+    grid->firstX = firstX;
+    grid->firstY = firstY;
+    grid->firstZ = firstZ;
+    grid->globalNx = globalNx;
+    grid->globalNy = globalNy;
+    grid->globalNz = globalNz;
+    grid->strideY = ((size_t)nx + 2 + floatsPerLine - 1) / floatsPerLine
+        * floatsPerLine;
+    grid->strideZ = grid->strideY * ((size_t)ny + 2);
+    grid->size = grid->strideZ * ((size_t)nz + 2);
+    grid->now = allocateFloats(grid->size);
+    grid->next = allocateFloats(grid->size);
+
+    /* Each thread first touches the planes it will update, so they are
+     * placed in its memory. */
+    #pragma omp parallel for schedule(static) private(y, x)
+    for (z = -1; z <= nz; z++) {
+        for (y = -1; y <= ny; y++) {
+            float *now = grid->now + GRID_INDEX(*grid, -1, y, z);
+            float *next = grid->next + GRID_INDEX(*grid, -1, y, z);
+
+            memset(now, 0, grid->strideY * sizeof(float));
+            memset(next, 0, grid->strideY * sizeof(float));
+
+            /* Set initial temperature; the x == 0 face is never updated,
+             * so it stays hot in both arrays. */
+            if (firstX == 0 && z >= 0 && z < nz && y >= 0 && y < ny) {
+                now[1] = INITIAL_TEMPERATURE;
+                next[1] = INITIAL_TEMPERATURE;
+            }
+        }
+    }
+
+    /* A point has one neighbor on each side that is not on a face of the
+     * whole grid. */
+    for (faces = 0; faces < 5; faces++) {
+        grid->inverseCounts[faces] = allocateFloats(nx > 0 ? nx : 1);
+        for (x = 0; x < nx; x++) {
+            globalX = firstX + x;
+            neighborCount = 6 - faces - (globalX == 0)
+                - (globalX == globalNx - 1);
+            grid->inverseCounts[faces][x] =
+                (neighborCount > 0) ? (1.0f / neighborCount) : 0.0f;
+        }
+    }
+}
+
+void freeGrid(heat_grid_t *grid) {
+    int faces;
+
+    for (faces = 0; faces < 5; faces++)
+        free(grid->inverseCounts[faces]);
+    free(grid->next);
+    free(grid->now);
+}
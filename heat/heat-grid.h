@@ -0,0 +1,79 @@
+/* PROGRAM: Simple Heat netCDF
+ * Grid - the temperatures of an NX x NY x NZ grid of points.
+ *
+ * The grid is stored as two flat float arrays, one for the temperatures now
+ * and one for the temperatures next, instead of an array of structs, so the
+ * stencil reads and writes whole cache lines of temperatures.  Each array has
+ * one layer of ghost points around the grid.  Ghost points are always 0, so a
+ * point on a face of the grid can add up all six neighbors without checking
+ * which of them exist; it is then divided by its real number of neighbors.
+ *
+ * x varies fastest, then y, then z.  Rows in x are padded to a whole number
+ * of cache lines.
+ *
+ * A grid can also be one block of a larger grid, as in heat-mpi.c.  Its
+ * ghost points on the faces it shares with other blocks then hold copies of
+ * their temperatures, and the source face and the neighbor counts are those
+ * of the whole grid.
+ */
+#ifndef HEAT_GRID_H
+#define HEAT_GRID_H
+
+#include <stddef.h>
+
+/* Points on the x == 0 face are held at this temperature; all other points
+ * start at 0. */
+#define INITIAL_TEMPERATURE 100.0f
+
+/* Rows are padded to, and the arrays are aligned to, this many bytes. */
+#define GRID_ALIGNMENT 64
+
+typedef struct {
+    /* Number of points in x, y and z, not counting ghost points. */
+    int nx, ny, nz;
+
+    /* Position of point (0, 0, 0) in the whole grid, and the size of the
+     * whole grid. */
+    int firstX, firstY, firstZ;
+    int globalNx, globalNy, globalNz;
+
+    /* Distance in floats between neighbors in y and in z. */
+    size_t strideY, strideZ;
+
+    /* Number of floats in each array, including ghost points. */
+    size_t size;
+
+    /* Temperatures now and next; swapped after every time step. */
+    float *now;
+    float *next;
+
+    /* 1 / neighborCount of each x in a row that touches 0 to 4 of the y and
+     * z faces: inverseCounts[faces][x]. */
+    float *inverseCounts[5];
+} heat_grid_t;
+
+/* Index in the arrays of interior point (x, y, z); ghost points are at -1 and
+ * at nx, ny or nz. */
+#define GRID_INDEX(grid, x, y, z) \
+    ((size_t)((z) + 1) * (grid).strideZ + (size_t)((y) + 1) * (grid).strideY \
+     + (size_t)((x) + 1))
+
+/* Allocate a grid and set its initial temperatures. */
+void initializeGrid(heat_grid_t *grid, const int nx, const int ny,
+                    const int nz);
+
+/* Allocate an nx x ny x nz block of a globalNx x globalNy x globalNz grid,
+ * whose point (0, 0, 0) is point (firstX, firstY, firstZ) of the whole grid,
+ * and set its initial temperatures. */
+void initializeBlock(heat_grid_t *grid, const int nx, const int ny,
+                     const int nz, const int firstX, const int firstY,
+                     const int firstZ, const int globalNx,
+                     const int globalNy, const int globalNz);
+
+/* Number of y and z faces of the whole grid that row (y, z) touches, used to
+ * index inverseCounts. */
+int countRowFaces(const heat_grid_t *grid, const int y, const int z);
+
+void freeGrid(heat_grid_t *grid);
+
+#endif
@@ -0,0 +1,155 @@
+/* PROGRAM: Simple Heat netCDF
+ * Halo - splits the grid into blocks on a 3D Cartesian grid of MPI
+ * processes, and exchanges the ghost points on the faces between blocks.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "heat-halo.h"
+#include "heat-stencil.h"
+
+/* Axes of the Cartesian communicator, slowest-varying first, as in the
+ * grid. */
+#define AXIS_Z 0
+#define AXIS_Y 1
+#define AXIS_X 2
+
+/* Split n points into parts; part i gets its share starting at *first. */
+static void distributePoints(const int n, const int parts, const int i,
+                             int *first, int *count) {
+    const int base = n / parts;
+    const int extra = n % parts;
+
+    *count = base + (i < extra);
+    *first = i * base + (i < extra ? i : extra);
+}
+
+void decomposeGrid(heat_halo_t *halo, heat_grid_t *grid, const int globalNx,
+                   const int globalNy, const int globalNz) {
+    const int globalSizes[3] = {globalNz, globalNy, globalNx};
+    int dims[3] = {0, 0, 0};
+    int periods[3] = {0, 0, 0};
+    int coords[3], firsts[3], counts[3];
+    int sizes[3], subsizes[3], starts[3] = {0, 0, 0};
+    int rank, size, axis;
+
+    MPI_Comm_size(MPI_COMM_WORLD, &size);
+    MPI_Dims_create(size, 3, dims);
+    MPI_Cart_create(MPI_COMM_WORLD, 3, dims, periods, 1, &(halo->comm));
+    MPI_Comm_rank(halo->comm, &rank);
+    MPI_Cart_coords(halo->comm, rank, 3, coords);
+
+    for (axis = 0; axis < 3; axis++) {
+        if (dims[axis] > globalSizes[axis]) {
+            if (rank == 0)
+                fprintf(stderr, "A %d x %d x %d grid cannot be split into "
+                        "%d x %d x %d blocks, exiting!\n", globalNx,
+                        globalNy, globalNz, dims[AXIS_X], dims[AXIS_Y],
+                        dims[AXIS_Z]);
+            MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+        }
+        distributePoints(globalSizes[axis], dims[axis], coords[axis],
+                         &firsts[axis], &counts[axis]);
+        MPI_Cart_shift(halo->comm, axis, 1, &(halo->lowRanks[2 - axis]),
+                       &(halo->highRanks[2 - axis]));
+    }
+
+    initializeBlock(grid, counts[AXIS_X], counts[AXIS_Y], counts[AXIS_Z],
+                    firsts[AXIS_X], firsts[AXIS_Y], firsts[AXIS_Z],
+                    globalNx, globalNy, globalNz);
+
+    /* A face is a subarray of the block's array, ghost points and padding
+     * included, starting at the address it is sent from or received to. */
+    sizes[AXIS_Z] = grid->nz + 2;
+    sizes[AXIS_Y] = grid->ny + 2;
+    sizes[AXIS_X] = (int)grid->strideY;
+    for (axis = 0; axis < 3; axis++) {
+        subsizes[AXIS_Z] = (axis == AXIS_Z) ? 1 : grid->nz;
+        subsizes[AXIS_Y] = (axis == AXIS_Y) ? 1 : grid->ny;
+        subsizes[AXIS_X] = (axis == AXIS_X) ? 1 : grid->nx;
+        MPI_Type_create_subarray(3, sizes, subsizes, starts, MPI_ORDER_C,
+                                 MPI_FLOAT, &(halo->faceTypes[2 - axis]));
+        MPI_Type_commit(&(halo->faceTypes[2 - axis]));
+    }
+}
+
+void startHaloExchange(heat_halo_t *halo, heat_grid_t *grid) {
+    /* Offsets of the first and last faces of the block in x, y and z, and
+     * of the ghost points just outside them. */
+    const size_t firstPoint = GRID_INDEX(*grid, 0, 0, 0);
+    const size_t lastPoint[3] = {GRID_INDEX(*grid, grid->nx - 1, 0, 0),
+                                 GRID_INDEX(*grid, 0, grid->ny - 1, 0),
+                                 GRID_INDEX(*grid, 0, 0, grid->nz - 1)};
+    const size_t lowGhost[3] = {GRID_INDEX(*grid, -1, 0, 0),
+                                GRID_INDEX(*grid, 0, -1, 0),
+                                GRID_INDEX(*grid, 0, 0, -1)};
+    const size_t highGhost[3] = {GRID_INDEX(*grid, grid->nx, 0, 0),
+                                 GRID_INDEX(*grid, 0, grid->ny, 0),
+                                 GRID_INDEX(*grid, 0, 0, grid->nz)};
+    int dim;
+
+    /* Tag 2 * dim carries faces moving down in dim, 2 * dim + 1 up. */
+    for (dim = 0; dim < 3; dim++) {
+        MPI_Irecv(grid->now + lowGhost[dim], 1, halo->faceTypes[dim],
+                  halo->lowRanks[dim], 2 * dim + 1, halo->comm,
+                  &(halo->requests[4 * dim]));
+        MPI_Irecv(grid->now + highGhost[dim], 1, halo->faceTypes[dim],
+                  halo->highRanks[dim], 2 * dim, halo->comm,
+                  &(halo->requests[4 * dim + 1]));
+        MPI_Isend(grid->now + firstPoint, 1, halo->faceTypes[dim],
+                  halo->lowRanks[dim], 2 * dim, halo->comm,
+                  &(halo->requests[4 * dim + 2]));
+        MPI_Isend(grid->now + lastPoint[dim], 1, halo->faceTypes[dim],
+                  halo->highRanks[dim], 2 * dim + 1, halo->comm,
+                  &(halo->requests[4 * dim + 3]));
+    }
+}
+
+void finishHaloExchange(heat_halo_t *halo) {
+    MPI_Waitall(12, halo->requests, MPI_STATUSES_IGNORE);
+}
+
+void stepBlock(heat_halo_t *halo, heat_grid_t *grid,
+               heat_residual_t *residual) {
+    const int nx = grid->nx, ny = grid->ny, nz = grid->nz;
+    /* The last plane, row or column, unless it is also the first. */
+    const int lastX = (nx > 1) ? nx - 1 : 1;
+    const int lastY = (ny > 1) ? ny - 1 : 1;
+    const int lastZ = (nz > 1) ? nz - 1 : 1;
+    heat_residual_t local = {0.0, 0.0f};
+    heat_residual_t *local_p = (residual != NULL) ? &local : NULL;
+
+    startHaloExchange(halo, grid);
+
+    /* The inside of the block needs no ghost points. */
+    stepRegion(grid, 1, nx - 1, 1, ny - 1, 1, nz - 1, local_p);
+
+    finishHaloExchange(halo);
+
+    /* The six faces of the block, split so that each point is updated, and
+     * its change counted, once. */
+    stepRegion(grid, 0, nx, 0, ny, 0, 1, local_p);
+    stepRegion(grid, 0, nx, 0, ny, lastZ, nz, local_p);
+    stepRegion(grid, 0, nx, 0, 1, 1, nz - 1, local_p);
+    stepRegion(grid, 0, nx, lastY, ny, 1, nz - 1, local_p);
+    stepRegion(grid, 0, 1, 1, ny - 1, 1, nz - 1, local_p);
+    stepRegion(grid, lastX, nx, 1, ny - 1, 1, nz - 1, local_p);
+
+    /* advance temperature. */
+    swapGrid(grid);
+
+    if (residual != NULL) {
+        MPI_Allreduce(&(local.sumSquares), &(residual->sumSquares), 1,
+                      MPI_DOUBLE, MPI_SUM, halo->comm);
+        MPI_Allreduce(&(local.maxChange), &(residual->maxChange), 1,
+                      MPI_FLOAT, MPI_MAX, halo->comm);
+    }
+}
+
+void freeHalo(heat_halo_t *halo) {
+    int dim;
+
+    for (dim = 0; dim < 3; dim++)
+        MPI_Type_free(&(halo->faceTypes[dim]));
+    MPI_Comm_free(&(halo->comm));
+}
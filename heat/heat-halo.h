@@ -0,0 +1,55 @@
+/* PROGRAM: Simple Heat netCDF
+ * Halo - splits the grid into blocks on a 3D Cartesian grid of MPI
+ * processes, and exchanges the ghost points on the faces between blocks.
+ *
+ * Each face is sent straight out of, and received straight into, the grid
+ * with an MPI subarray datatype, so nothing is packed by hand.  The exchange
+ * is nonblocking: it is started, the inside of the block (which needs no
+ * ghost points) is updated, and only then does the process wait for it and
+ * update the edges of the block.
+ */
+#ifndef HEAT_HALO_H
+#define HEAT_HALO_H
+
+#include <mpi.h>
+#include "heat-grid.h"
+#include "heat-stencil.h"
+
+typedef struct {
+    /* The Cartesian communicator; its dimensions 0, 1 and 2 are z, y and x. */
+    MPI_Comm comm;
+
+    /* Ranks of the neighbors below and above in x, y and z, or
+     * MPI_PROC_NULL on the faces of the whole grid. */
+    int lowRanks[3];
+    int highRanks[3];
+
+    /* Faces normal to x, y and z. */
+    MPI_Datatype faceTypes[3];
+
+    /* Requests of the exchange in progress. */
+    MPI_Request requests[12];
+} heat_halo_t;
+
+/* Split a globalNx x globalNy x globalNz grid as evenly as possible across
+ * the processes, and allocate this process's block.  Exits if some process
+ * would get no points. */
+void decomposeGrid(heat_halo_t *halo, heat_grid_t *grid, const int globalNx,
+                   const int globalNy, const int globalNz);
+
+/* Start sending the faces of the block's current temperatures to the
+ * neighbors and receiving theirs into the ghost points. */
+void startHaloExchange(heat_halo_t *halo, heat_grid_t *grid);
+
+/* Wait for the exchange to finish. */
+void finishHaloExchange(heat_halo_t *halo);
+
+/* Advance the block one time step, overlapping the exchange with the update
+ * of its inside, then swap now and next.  Unless residual is NULL, set it to
+ * how much the whole grid changed, which every process waits for. */
+void stepBlock(heat_halo_t *halo, heat_grid_t *grid,
+               heat_residual_t *residual);
+
+void freeHalo(heat_halo_t *halo);
+
+#endif
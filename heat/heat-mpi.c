@@ -0,0 +1,147 @@
+/* PROGRAM: Simple Heat netCDF - MPI version
+ *
+ * The same simulation as heat.c, with the grid split into blocks across MPI
+ * processes on a 3D Cartesian grid (see heat-halo.h), each process updating
+ * its block with OpenMP threads.  Every process writes its block of the
+ * temperatures into one file with parallel netCDF, laid out as heat.c lays
+ * it out (see heat-output.h).  The options are the same as heat.c's; see
+ * heat-config.h.  Writing is synchronous if the MPI library does not support
+ * MPI_THREAD_MULTIPLE, which the I/O thread needs.
+ *
+ * As in heat.c, the residual of each time step is measured only if it is
+ * written or -e needs it; it is then summed over the processes, which every
+ * process waits for.
+ */
+
+#include <mpi.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <omp.h>
+#include "heat-config.h"
+#include "heat-grid.h"
+#include "heat-stencil.h"
+#include "heat-halo.h"
+#include "heat-output.h"
+
+int main(int argc, char **argv) {
+    heat_config_t config;
+
+    /* Loop index, and whether the temperatures stopped changing. */
+    int time;
+    bool isConverged = false;
+
+    /* Timing; each is the slowest process's. */
+    double runStartTime, startTime, times[5];
+
+    /* Data Structure (what the model has) */
+    heat_grid_t grid;
+    heat_halo_t halo;
+    heat_output_t output;
+    heat_residual_t residual = {0.0, 0.0f};
+    heat_residual_t *residual_p;
+    double pointCount;
+
+    /* MPI */
+    int rank, size, threadSupport;
+
+    /* The master thread and the I/O thread make MPI calls at once. */
+    MPI_Init_thread(&argc, &argv, MPI_THREAD_MULTIPLE, &threadSupport);
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &size);
+
+    parseConfig(&config, argc, argv);
+    if (config.method != METHOD_JACOBI) {
+        if (rank == 0)
+            fprintf(stderr, "Only -m jacobi runs across processes; use heat "
+                    "for %s, exiting!\n", config.methodName);
+        MPI_Finalize();
+        exit(EXIT_FAILURE);
+    }
+    if (config.timeBlock > 1) {
+        if (rank == 0)
+            fprintf(stderr, "Temporal blocking needs halos as deep as -T; "
+                    "use heat for -T %d, exiting!\n", config.timeBlock);
+        MPI_Finalize();
+        exit(EXIT_FAILURE);
+    }
+    if (config.isWriting && config.isAsync
+            && threadSupport < MPI_THREAD_MULTIPLE) {
+        if (rank == 0)
+            printf("MPI_THREAD_MULTIPLE is not supported; writing "
+                   "synchronously\n");
+        config.isAsync = false;
+    }
+    pointCount = (double)config.nx * config.ny * config.nz;
+    residual_p = (config.isWriting || config.tolerance > 0.0) ?
+        &residual : NULL;
+
+    /* Algorithm (how the model computes) */
+    MPI_Barrier(MPI_COMM_WORLD);
+    runStartTime = MPI_Wtime();
+
+    /* Allocate this process's block and set its initial temperatures and
+     * neighbor counts. */
+    decomposeGrid(&halo, &grid, config.nx, config.ny, config.nz);
+
+    if (config.isWriting)
+        openOutput(&output, config.fileName, &grid, config.deflateLevel,
+                   config.isAsync);
+
+    times[0] = 0.0;
+    for (time = 0; time < config.ntime; time++) {
+        /* Write the temperatures now, then compute the next ones. */
+        if (config.isWriting && time % config.outputInterval == 0)
+            writeOutput(&output, &grid, time);
+
+        startTime = MPI_Wtime();
+        stepBlock(&halo, &grid, residual_p);
+        times[0] += MPI_Wtime() - startTime;
+
+        if (config.isWriting)
+            recordResidual(&output, time + 1,
+                           (float)residualL2(&residual, pointCount),
+                           residual.maxChange);
+        if (residual_p != NULL && residual.maxChange < config.tolerance) {
+            isConverged = true;
+            time++;
+            break;
+        }
+    }
+
+    if (config.isWriting) {
+        if (isConverged && time % config.outputInterval != 0)
+            writeOutput(&output, &grid, time);
+        closeOutput(&output);
+    }
+    times[1] = MPI_Wtime() - runStartTime;
+    times[2] = config.isWriting ? output.writeTime : 0.0;
+    times[3] = config.isWriting ? output.copyTime : 0.0;
+    times[4] = config.isWriting ? output.waitTime : 0.0;
+
+    MPI_Reduce((rank == 0) ? MPI_IN_PLACE : times, times, 5, MPI_DOUBLE,
+               MPI_MAX, 0, MPI_COMM_WORLD);
+
+    if (rank == 0) {
+        printf("Grid = %d x %d x %d, %d time steps, %d processes x %d "
+               "threads\n", config.nx, config.ny, config.nz, config.ntime,
+               size, omp_get_max_threads());
+        printf("Grid point updates per second = %e\n",
+               pointCount * time / times[0]);
+        if (residual_p != NULL)
+            printf("Residual after %d time steps%s: L2 = %e, max = %e\n",
+                   time, isConverged ? " (converged)" : "",
+                   residualL2(&residual, pointCount), residual.maxChange);
+        if (config.isWriting)
+            printOutputTimes(times[2], times[3], times[4], times[1],
+                             (double)config.nx * config.ny * config.nz
+                             * sizeof(float) * output.timeCount);
+    }
+
+    freeHalo(&halo);
+    freeGrid(&grid);
+
+    MPI_Finalize();
+
+    return 0;
+}
@@ -0,0 +1,449 @@
+/* PROGRAM: Simple Heat netCDF
+ * Output - writes the temperatures to a netCDF file, one time step at a time.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <omp.h>
+#include <netcdf.h>
+#ifdef HEAT_MPI
+#include <mpi.h>
+#include <netcdf_par.h>
+#endif
+#include "heat-output.h"
+
+/* We are writing 4D data: an x-y-z grid for each time step. */
+#define NDIMS 4
+#define TIME_NAME "time"
+#define STEP_NAME "step"
+#define X_NAME "columns"
+#define Y_NAME "rows"
+#define Z_NAME "depth"
+
+/* Names of things. */
+#define TEMP_NAME "temperature"
+#define L2_NAME "residual_l2"
+#define MAX_NAME "residual_max"
+#define RESIDUAL_STEP_NAME "residual_step"
+#define X_UNITS "cm"
+#define Y_UNITS "cm"
+#define Z_UNITS "cm"
+#define TIME_UNITS "seconds"
+#define TEMPERATURE_UNITS "degrees F"
+
+/* For the units attributes. */
+#define MAX_ATT_LEN 80
+
+/* Handle errors by printing an error message and exiting in failure */
+#define ERR(e) {printf("Error: %s\n", nc_strerror(e)); exit(EXIT_FAILURE);}
+
+static void *allocate(const size_t size) {
+    void *memory = malloc(size);
+
+    if (memory == NULL) {
+        fprintf(stderr, "Could not allocate %lu bytes, exiting!\n",
+                (unsigned long)size);
+        exit(EXIT_FAILURE);
+    }
+
+    return memory;
+}
+
+/* Write the coordinates 0, 1, ..., n-1 of a dimension. */
+static void writeCoordinates(const int ncid, const int varid, const int n) {
+    int *coords = (int*)allocate(n * sizeof(int));
+    int i, retval;
+
+    for (i = 0; i < n; i++)
+        coords[i] = i;
+    if ((retval = nc_put_var_int(ncid, varid, coords)))
+        ERR(retval);
+
+    free(coords);
+}
+
+/* Chunks hold one time step and as many whole planes in z as fit in
+ * CHUNK_BYTES, or if one plane does not fit, as many whole rows in y. */
+static void calculateChunkSizes(const int nx, const int ny, const int nz,
+                                size_t chunkSizes[NDIMS]) {
+    const size_t rowBytes = (size_t)nx * sizeof(float);
+    const size_t planeBytes = rowBytes * ny;
+
+    chunkSizes[0] = 1;
+    chunkSizes[3] = nx;
+    if (planeBytes <= CHUNK_BYTES) {
+        chunkSizes[2] = ny;
+        chunkSizes[1] = CHUNK_BYTES / planeBytes;
+        if (chunkSizes[1] > (size_t)nz)
+            chunkSizes[1] = nz;
+    } else {
+        chunkSizes[1] = 1;
+        chunkSizes[2] = (rowBytes < CHUNK_BYTES) ? CHUNK_BYTES / rowBytes : 1;
+    }
+}
+
+/* Make the netCDF calls for one time step. */
+static void writeTimeStep(heat_output_t *output, const float *temp_out,
+                          const size_t index, const float timeCoord) {
+    const double startTime = omp_get_wtime();
+    size_t start[NDIMS], count[NDIMS];
+    int retval;
+
+    /* These settings tell netCDF to write this process's block of one
+     * timestep of data. */
+    start[0] = index;
+    start[1] = output->firstZ;
+    start[2] = output->firstY;
+    start[3] = output->firstX;
+    count[0] = 1;
+    count[1] = output->nz;
+    count[2] = output->ny;
+    count[3] = output->nx;
+    if ((retval = nc_put_vara_float(output->ncid, output->temp_varid, start,
+                    count, temp_out)))
+        ERR(retval);
+    if ((retval = nc_put_var1_float(output->ncid, output->time_varid, &index,
+                    &timeCoord)))
+        ERR(retval);
+
+    output->writeTime += omp_get_wtime() - startTime;
+}
+
+/* The I/O thread: write the time steps handed over by writeOutput() until
+ * closeOutput() says there are no more. */
+static void *writeTimeSteps(void *argument) {
+    heat_output_t *output = (heat_output_t*)argument;
+    const float *temp_out;
+    size_t index;
+    float timeCoord;
+
+    pthread_mutex_lock(&(output->mutex));
+    while (1) {
+        while (output->pending == NULL && !output->isFinished)
+            pthread_cond_wait(&(output->condition), &(output->mutex));
+        if (output->pending == NULL)
+            break;
+        temp_out = output->pending;
+        index = output->pendingIndex;
+        timeCoord = output->pendingTime;
+
+        /* Write without the lock, so the next time step can be copied
+         * meanwhile. */
+        pthread_mutex_unlock(&(output->mutex));
+        writeTimeStep(output, temp_out, index, timeCoord);
+        pthread_mutex_lock(&(output->mutex));
+
+        output->pending = NULL;
+        pthread_cond_broadcast(&(output->condition));
+    }
+    pthread_mutex_unlock(&(output->mutex));
+
+    return NULL;
+}
+
+void openOutput(heat_output_t *output, const char *fileName,
+                const heat_grid_t *grid, const int deflateLevel,
+                const bool isAsync) {
+    const size_t blockSize = (size_t)grid->nx * grid->ny * grid->nz;
+    const int nx = grid->globalNx, ny = grid->globalNy, nz = grid->globalNz;
+
+    /* IDs for the netCDF file, dimensions, and variables. */
+    int ncid, x_dimid, y_dimid, z_dimid, time_dimid, step_dimid;
+    int x_varid, y_varid, z_varid, time_varid, temp_varid;
+    int l2_varid, max_varid, step_varid;
+    int dimids[NDIMS];
+    size_t chunkSizes[NDIMS];
+
+    /* Error handling. */
+    int retval;
+
+    output->nx = grid->nx;
+    output->ny = grid->ny;
+    output->nz = grid->nz;
+    output->firstX = grid->firstX;
+    output->firstY = grid->firstY;
+    output->firstZ = grid->firstZ;
+    output->temp_out[0] = (float*)allocate(blockSize * sizeof(float));
+    output->temp_out[1] = (float*)allocate(blockSize * sizeof(float));
+    output->fillIdx = 0;
+    output->isAsync = isAsync;
+    output->pending = NULL;
+    output->isFinished = false;
+    output->timeCount = 0;
+    output->residuals[0] = NULL;
+    output->residuals[1] = NULL;
+    output->residualSteps = NULL;
+    output->stepCount = 0;
+    output->stepCapacity = 0;
+    output->writeTime = 0.0;
+    output->copyTime = 0.0;
+    output->waitTime = 0.0;
+
+    /* Create the netCDF file, shared by every process with HEAT_MPI. */
+#ifdef HEAT_MPI
+    MPI_Comm_dup(MPI_COMM_WORLD, &(output->comm));
+    if ((retval = nc_create_par(fileName, NC_CLOBBER | NC_NETCDF4,
+                    output->comm, MPI_INFO_NULL, &ncid)))
+        ERR(retval);
+#else
+    if ((retval = nc_create(fileName, NC_CLOBBER | NC_NETCDF4, &ncid)))
+        ERR(retval);
+#endif
+
+    /* Define the dimensions; time grows with every time step written. */
+    if ((retval = nc_def_dim(ncid, TIME_NAME, NC_UNLIMITED, &time_dimid)))
+        ERR(retval);
+    if ((retval = nc_def_dim(ncid, X_NAME, nx, &x_dimid)))
+        ERR(retval);
+    if ((retval = nc_def_dim(ncid, Y_NAME, ny, &y_dimid)))
+        ERR(retval);
+    if ((retval = nc_def_dim(ncid, Z_NAME, nz, &z_dimid)))
+        ERR(retval);
+
+    /* step grows with every time step computed, written or not. */
+    if ((retval = nc_def_dim(ncid, STEP_NAME, NC_UNLIMITED, &step_dimid)))
+        ERR(retval);
+
+    /* Define the coordinate variables. */
+    if ((retval = nc_def_var(ncid, TIME_NAME, NC_FLOAT, 1, &time_dimid,
+                    &time_varid)))
+        ERR(retval);
+    if ((retval = nc_def_var(ncid, X_NAME, NC_FLOAT, 1, &x_dimid, &x_varid)))
+        ERR(retval);
+    if ((retval = nc_def_var(ncid, Y_NAME, NC_FLOAT, 1, &y_dimid, &y_varid)))
+        ERR(retval);
+    if ((retval = nc_def_var(ncid, Z_NAME, NC_FLOAT, 1, &z_dimid, &z_varid)))
+        ERR(retval);
+
+    /* Assign units attributes to coordinate variables */
+    if ((retval = nc_put_att_text(ncid, time_varid, TIME_UNITS, strlen(TIME_UNITS),
+                    TIME_UNITS)))
+        ERR(retval);
+    if ((retval = nc_put_att_text(ncid, x_varid, X_UNITS, strlen(X_UNITS), X_UNITS)))
+        ERR(retval);
+    if ((retval = nc_put_att_text(ncid, y_varid, Y_UNITS, strlen(Y_UNITS), Y_UNITS)))
+        ERR(retval);
+    if ((retval = nc_put_att_text(ncid, z_varid, Z_UNITS, strlen(Z_UNITS), Z_UNITS)))
+        ERR(retval);
+
+    /* The dimids array is used to pass the dimids of the dimensions of
+     * the netCDF variables, slowest-varying first, in the order the grid
+     * stores them. */
+    dimids[0] = time_dimid;
+    dimids[1] = z_dimid;
+    dimids[2] = y_dimid;
+    dimids[3] = x_dimid;
+
+    /* Define the netCDF variables for the temperature data. */
+    if ((retval = nc_def_var(ncid, TEMP_NAME, NC_FLOAT, NDIMS, dimids,
+                    &temp_varid)))
+        ERR(retval);
+
+    /* Every value is written, so do not fill the chunks first. */
+    calculateChunkSizes(nx, ny, nz, chunkSizes);
+    if ((retval = nc_def_var_chunking(ncid, temp_varid, NC_CHUNKED,
+                    chunkSizes)))
+        ERR(retval);
+    if ((retval = nc_def_var_fill(ncid, temp_varid, 1, NULL)))
+        ERR(retval);
+    if (deflateLevel > 0) {
+        if ((retval = nc_def_var_deflate(ncid, temp_varid, 1, 1,
+                        deflateLevel)))
+            ERR(retval);
+    }
+
+    /* Assign units attributes to the netCDF temperature variable. */
+    if ((retval = nc_put_att_text(ncid, temp_varid, TEMPERATURE_UNITS, strlen(TEMPERATURE_UNITS),
+                    TEMPERATURE_UNITS)))
+        ERR(retval);
+
+    /* Define the residual history, one value per residual measured, and
+     * the time step each was measured after. */
+    if ((retval = nc_def_var(ncid, RESIDUAL_STEP_NAME, NC_INT, 1,
+                    &step_dimid, &step_varid)))
+        ERR(retval);
+    if ((retval = nc_def_var(ncid, L2_NAME, NC_FLOAT, 1, &step_dimid,
+                    &l2_varid)))
+        ERR(retval);
+    if ((retval = nc_def_var(ncid, MAX_NAME, NC_FLOAT, 1, &step_dimid,
+                    &max_varid)))
+        ERR(retval);
+    if ((retval = nc_put_att_text(ncid, l2_varid, TEMPERATURE_UNITS,
+                    strlen(TEMPERATURE_UNITS), TEMPERATURE_UNITS)))
+        ERR(retval);
+    if ((retval = nc_put_att_text(ncid, max_varid, TEMPERATURE_UNITS,
+                    strlen(TEMPERATURE_UNITS), TEMPERATURE_UNITS)))
+        ERR(retval);
+
+    /* End define mode */
+    if ((retval = nc_enddef(ncid)))
+        ERR(retval);
+
+#ifdef HEAT_MPI
+    /* Writes that extend the unlimited time dimension must be collective. */
+    if ((retval = nc_var_par_access(ncid, temp_varid, NC_COLLECTIVE)))
+        ERR(retval);
+    if ((retval = nc_var_par_access(ncid, time_varid, NC_COLLECTIVE)))
+        ERR(retval);
+    if ((retval = nc_var_par_access(ncid, l2_varid, NC_COLLECTIVE)))
+        ERR(retval);
+    if ((retval = nc_var_par_access(ncid, max_varid, NC_COLLECTIVE)))
+        ERR(retval);
+    if ((retval = nc_var_par_access(ncid, step_varid, NC_COLLECTIVE)))
+        ERR(retval);
+#endif
+
+    /* Write the coordinate variable data; every process writes the same
+     * values. */
+    writeCoordinates(ncid, x_varid, nx);
+    writeCoordinates(ncid, y_varid, ny);
+    writeCoordinates(ncid, z_varid, nz);
+
+    output->ncid = ncid;
+    output->time_varid = time_varid;
+    output->temp_varid = temp_varid;
+    output->l2_varid = l2_varid;
+    output->max_varid = max_varid;
+    output->step_varid = step_varid;
+
+    if (isAsync) {
+        pthread_mutex_init(&(output->mutex), NULL);
+        pthread_cond_init(&(output->condition), NULL);
+        if (pthread_create(&(output->thread), NULL, writeTimeSteps,
+                    output) != 0) {
+            fprintf(stderr, "Could not start the I/O thread, exiting!\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+}
+
+void writeOutput(heat_output_t *output, const heat_grid_t *grid,
+                 const int time) {
+    const int nx = output->nx, ny = output->ny, nz = output->nz;
+    float *temp_out = output->temp_out[output->fillIdx];
+    double startTime = omp_get_wtime();
+    int y, z;
+
+    /* Copy the rows out of the grid, leaving out the ghost points.  The I/O
+     * thread is never writing the buffer being filled. */
+    #pragma omp parallel for schedule(static) private(y)
+    for (z = 0; z < nz; z++)
+        for (y = 0; y < ny; y++)
+            memcpy(temp_out + ((size_t)z * ny + y) * nx,
+                   grid->now + GRID_INDEX(*grid, 0, y, z),
+                   nx * sizeof(float));
+    output->copyTime += omp_get_wtime() - startTime;
+
+    startTime = omp_get_wtime();
+    if (output->isAsync) {
+        /* Hand the time step over once the one before has been written, and
+         * fill the other buffer next time. */
+        pthread_mutex_lock(&(output->mutex));
+        while (output->pending != NULL)
+            pthread_cond_wait(&(output->condition), &(output->mutex));
+        output->pending = temp_out;
+        output->pendingIndex = output->timeCount;
+        output->pendingTime = (float)time;
+        pthread_cond_broadcast(&(output->condition));
+        pthread_mutex_unlock(&(output->mutex));
+        output->fillIdx = 1 - output->fillIdx;
+    } else {
+        writeTimeStep(output, temp_out, output->timeCount, (float)time);
+    }
+    output->waitTime += omp_get_wtime() - startTime;
+
+    output->timeCount++;
+}
+
+void recordResidual(heat_output_t *output, const int step, const float l2,
+                    const float maxChange) {
+    int i;
+
+    if (output->stepCount == output->stepCapacity) {
+        output->stepCapacity = (output->stepCapacity > 0) ?
+            2 * output->stepCapacity : 1024;
+        for (i = 0; i < 2; i++) {
+            output->residuals[i] = (float*)realloc(output->residuals[i],
+                    output->stepCapacity * sizeof(float));
+            if (output->residuals[i] == NULL) {
+                fprintf(stderr, "Could not allocate the residual history, "
+                        "exiting!\n");
+                exit(EXIT_FAILURE);
+            }
+        }
+        output->residualSteps = (int*)realloc(output->residualSteps,
+                output->stepCapacity * sizeof(int));
+        if (output->residualSteps == NULL) {
+            fprintf(stderr, "Could not allocate the residual history, "
+                    "exiting!\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    output->residualSteps[output->stepCount] = step;
+    output->residuals[0][output->stepCount] = l2;
+    output->residuals[1][output->stepCount] = maxChange;
+    output->stepCount++;
+}
+
+void closeOutput(heat_output_t *output) {
+    const size_t start = 0;
+    double startTime = omp_get_wtime();
+    int retval;
+
+    if (output->isAsync) {
+        pthread_mutex_lock(&(output->mutex));
+        output->isFinished = true;
+        pthread_cond_broadcast(&(output->condition));
+        pthread_mutex_unlock(&(output->mutex));
+        pthread_join(output->thread, NULL);
+        pthread_cond_destroy(&(output->condition));
+        pthread_mutex_destroy(&(output->mutex));
+    }
+    output->waitTime += omp_get_wtime() - startTime;
+
+    /* Write the residual history, now that the I/O thread is done with the
+     * file, and close it.  With HEAT_MPI every process writes the same
+     * values. */
+    startTime = omp_get_wtime();
+    if (output->stepCount > 0) {
+        if ((retval = nc_put_vara_float(output->ncid, output->l2_varid,
+                        &start, &(output->stepCount), output->residuals[0])))
+            ERR(retval);
+        if ((retval = nc_put_vara_float(output->ncid, output->max_varid,
+                        &start, &(output->stepCount), output->residuals[1])))
+            ERR(retval);
+        if ((retval = nc_put_vara_int(output->ncid, output->step_varid,
+                        &start, &(output->stepCount), output->residualSteps)))
+            ERR(retval);
+    }
+    if ((retval = nc_close(output->ncid)))
+        ERR(retval);
+    output->writeTime += omp_get_wtime() - startTime;
+    output->waitTime += omp_get_wtime() - startTime;
+
+#ifdef HEAT_MPI
+    MPI_Comm_free(&(output->comm));
+#endif
+    free(output->residualSteps);
+    free(output->residuals[1]);
+    free(output->residuals[0]);
+    free(output->temp_out[1]);
+    free(output->temp_out[0]);
+}
+
+void printOutputTimes(const double writeTime, const double copyTime,
+                      const double waitTime, const double runTime,
+                      const double bytes) {
+    double hidden = (writeTime > 0.0) ? 1.0 - waitTime / writeTime : 0.0;
+
+    if (hidden < 0.0)
+        hidden = 0.0;
+    printf("Output = %.3f s writing, %.1f MB/s\n", writeTime,
+           bytes / writeTime / 1e6);
+    printf("Solver stalled = %.3f s copying + %.3f s waiting "
+           "(%.1f%% of %.3f s run)\n", copyTime, waitTime,
+           100.0 * (copyTime + waitTime) / runTime, runTime);
+    printf("Writing overlapped with solving = %.1f%%\n", 100.0 * hidden);
+}
@@ -0,0 +1,135 @@
+/* PROGRAM: Simple Heat netCDF
+ * Output - writes the temperatures to a netCDF file, one time step at a time.
+ *
+ * The temperature variable is temperature[time][depth][rows][columns], the
+ * same order as the points are stored in memory, so each time step is copied
+ * out of the grid a row at a time and written with one nc_put_vara_float()
+ * call with start[0] = time and count[0] = 1.  time is an unlimited dimension,
+ * so the file can be read while it grows, and holds the time steps actually
+ * written.
+ *
+ * Compiled with HEAT_MPI defined, as for heat-mpi.c, the grid is one block of
+ * the whole grid and every process writes its block of each time step into
+ * the same file with collective parallel netCDF, so the file is the same as
+ * heat.c would write.
+ *
+ * Writing is asynchronous unless turned off: writeOutput() copies the time
+ * step into one of two buffers and hands it to an I/O thread, which makes
+ * the netCDF calls while the solver carries on.  If the I/O thread is still
+ * writing the time step before, writeOutput() waits for it, so at most two
+ * time steps are ever held.  With HEAT_MPI the I/O threads of the processes
+ * write collectively on their own communicator, which needs
+ * MPI_THREAD_MULTIPLE.
+ *
+ * The file also holds the residual history: residual_l2 and residual_max
+ * have one value for every time the residual is measured, along their own
+ * unlimited dimension, step.  That is once per time step, or once per block
+ * of time steps with -T, so residual_step holds the number of time steps
+ * computed when each value was measured.  They are kept in memory and
+ * written when the file is closed, so the I/O thread is the only thread
+ * using the file until then.
+ *
+ * The file is netCDF-4.  The temperature variable is split into chunks of
+ * one time step and whole planes (or whole rows, if a plane is too big) of
+ * about CHUNK_BYTES, so each write fills whole chunks and a reader of one
+ * time step or one plane decompresses little else.  It can be compressed
+ * with deflate.
+ */
+#ifndef HEAT_OUTPUT_H
+#define HEAT_OUTPUT_H
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <pthread.h>
+#ifdef HEAT_MPI
+#include <mpi.h>
+#endif
+#include "heat-grid.h"
+
+/* Target size of a chunk of the temperature variable. */
+#define CHUNK_BYTES (4 * 1024 * 1024)
+
+typedef struct {
+    /* IDs for the netCDF file and the variables written every time step. */
+    int ncid;
+    int time_varid, temp_varid;
+    int l2_varid, max_varid, step_varid;
+
+    /* Size of this process's block of a time step, and where it starts. */
+    int nx, ny, nz;
+    int firstX, firstY, firstZ;
+
+#ifdef HEAT_MPI
+    /* Communicator for the netCDF calls, apart from the solver's. */
+    MPI_Comm comm;
+#endif
+
+    /* Two buffers for one time step of this process's temperatures,
+     * [z][y][x]: one is filled while the other is written. */
+    float *temp_out[2];
+    int fillIdx;
+
+    /* true if an I/O thread writes the time steps. */
+    bool isAsync;
+
+    /* The I/O thread, and the lock and condition that hand time steps over
+     * to it. */
+    pthread_t thread;
+    pthread_mutex_t mutex;
+    pthread_cond_t condition;
+
+    /* The time step waiting to be or being written: its buffer, or NULL once
+     * it has been written, its index along the time dimension and its
+     * time. */
+    const float *pending;
+    size_t pendingIndex;
+    float pendingTime;
+
+    /* true once no more time steps will be handed over. */
+    bool isFinished;
+
+    /* Number of time steps handed over. */
+    size_t timeCount;
+
+    /* The L2 and largest changes measured so far, the number of time steps
+     * computed when each was measured, and how many there is room for. */
+    float *residuals[2];
+    int *residualSteps;
+    size_t stepCount, stepCapacity;
+
+    /* Seconds spent making the netCDF calls, copying time steps out of the
+     * grid, and waiting for the I/O thread (or, when writing synchronously,
+     * for the netCDF calls). */
+    double writeTime, copyTime, waitTime;
+} heat_output_t;
+
+/* Create the file and define its dimensions and variables, sized for the
+ * whole grid of which grid is a block, and start the I/O thread if isAsync.
+ * deflateLevel is from 0 (no compression) to 9.  With HEAT_MPI, every
+ * process must call this and the other functions together. */
+void openOutput(heat_output_t *output, const char *fileName,
+                const heat_grid_t *grid, const int deflateLevel,
+                const bool isAsync);
+
+/* Write the current temperatures of the grid as the given time step. */
+void writeOutput(heat_output_t *output, const heat_grid_t *grid,
+                 const int time);
+
+/* Add how much the latest time step, or block of time steps, changed the
+ * temperatures to the residual history; step is the number of time steps
+ * computed so far. */
+void recordResidual(heat_output_t *output, const int step, const float l2,
+                    const float maxChange);
+
+/* Wait for the last time step to be written, stop the I/O thread, write
+ * the residual history and close the file. */
+void closeOutput(heat_output_t *output);
+
+/* Print how long the solver spent on output and how much of the writing it
+ * did not have to wait for.  The times are passed in, so that heat-mpi.c
+ * can pass the slowest process's. */
+void printOutputTimes(const double writeTime, const double copyTime,
+                      const double waitTime, const double runTime,
+                      const double bytes);
+
+#endif
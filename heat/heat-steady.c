@@ -0,0 +1,407 @@
+/* PROGRAM: Simple Heat netCDF
+ * Steady - solves for the temperatures the time steps converge to.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "heat-steady.h"
+
+/* Index in a coarse grid's arrays of cell (x, y, z). */
+#define LEVEL_INDEX(level, x, y, z) \
+    ((size_t)((z) + 1) * (level).strideZ + (size_t)((y) + 1) * (level).strideY \
+     + (size_t)((x) + 1))
+
+static void *allocate(const size_t size) {
+    void *memory = calloc(1, size);
+
+    if (memory == NULL) {
+        fprintf(stderr, "Could not allocate %lu bytes, exiting!\n",
+                (unsigned long)size);
+        exit(EXIT_FAILURE);
+    }
+
+    return memory;
+}
+
+float calculateOmega(const heat_grid_t *grid) {
+    /* The slowest Jacobi mode is constant in y and z, and a quarter wave in
+     * x from the x == 0 face to the insulated far face. */
+    const double theta = (grid->globalNx > 1) ?
+        M_PI / (2.0 * (grid->globalNx - 1)) : M_PI / 2.0;
+    const double rho = (4.0 + 2.0 * cos(theta)) / 6.0;
+
+    return (float)(2.0 / (1.0 + sqrt(1.0 - rho * rho)));
+}
+
+/* Update the points of one colour, those whose x + y + z in the whole grid
+ * is even (0) or odd (1), and add their changes before over-relaxation to
+ * sumSquares and maxChange. */
+static void sweepColour(heat_grid_t *grid, const float omega,
+                        const int colour, double *sumSquares_p,
+                        float *maxChange_p) {
+    const int nx = grid->nx, ny = grid->ny, nz = grid->nz;
+    const ptrdiff_t strideY = (ptrdiff_t)grid->strideY;
+    const ptrdiff_t strideZ = (ptrdiff_t)grid->strideZ;
+    double sumSquares = 0.0;
+    float maxChange = 0.0f;
+    int y, z;
+
+    #pragma omp parallel for collapse(2) schedule(static) \
+        reduction(+:sumSquares) reduction(max:maxChange)
+    for (z = 0; z < nz; z++) {
+        for (y = 0; y < ny; y++) {
+            float *now = grid->now + GRID_INDEX(*grid, 0, y, z);
+            const float *inverseCount =
+                grid->inverseCounts[countRowFaces(grid, y, z)];
+            int x = (colour + grid->firstX + grid->firstY + y + grid->firstZ
+                     + z) & 1;
+            double rowSum = 0.0, rowMax = 0.0;
+
+            /* The source face is never updated. */
+            if (grid->firstX == 0 && x == 0)
+                x = 2;
+            for (; x < nx; x += 2) {
+                const double change = ((double)now[x - 1] + now[x + 1]
+                                       + now[x - strideY] + now[x + strideY]
+                                       + now[x - strideZ] + now[x + strideZ])
+                    * inverseCount[x] - now[x];
+
+                now[x] = (float)(now[x] + omega * change);
+                rowSum += change * change;
+                rowMax = (fabs(change) > rowMax) ? fabs(change) : rowMax;
+            }
+
+            sumSquares += rowSum;
+            maxChange = (rowMax > maxChange) ? (float)rowMax : maxChange;
+        }
+    }
+
+    *sumSquares_p += sumSquares;
+    if (maxChange > *maxChange_p)
+        *maxChange_p = maxChange;
+}
+
+void sweepRedBlack(heat_grid_t *grid, const float omega,
+                   heat_residual_t *residual) {
+    heat_residual_t sweep = {0.0, 0.0f};
+
+    sweepColour(grid, omega, 0, &(sweep.sumSquares), &(sweep.maxChange));
+    sweepColour(grid, omega, 1, &(sweep.sumSquares), &(sweep.maxChange));
+
+    if (residual != NULL)
+        *residual = sweep;
+}
+
+/* Sum of the couplings times the corrections of the neighbors of the cell
+ * whose correction is at e, which is cell (x, y, z); sets diagonal to the
+ * sum of the couplings. */
+static float sumNeighbors(const heat_level_t *level, const float *e,
+                          const int x, const int y, const int z,
+                          float *diagonal) {
+    const ptrdiff_t strideY = (ptrdiff_t)level->strideY;
+    const ptrdiff_t strideZ = (ptrdiff_t)level->strideZ;
+    const float areaX = level->extents[1][y] * level->extents[2][z];
+    const float areaY = level->extents[0][x] * level->extents[2][z];
+    const float areaZ = level->extents[0][x] * level->extents[1][y];
+    const float lowX = areaX * level->lowWeights[0][x];
+    const float highX = areaX * level->highWeights[0][x];
+    const float lowY = areaY * level->lowWeights[1][y];
+    const float highY = areaY * level->highWeights[1][y];
+    const float lowZ = areaZ * level->lowWeights[2][z];
+    const float highZ = areaZ * level->highWeights[2][z];
+
+    *diagonal = lowX + highX + lowY + highY + lowZ + highZ;
+
+    return lowX * e[-1] + highX * e[1] + lowY * e[-strideY]
+        + highY * e[strideY] + lowZ * e[-strideZ] + highZ * e[strideZ];
+}
+
+/* Gauss-Seidel update of the cells of one colour of a coarse grid. */
+static void smoothLevel(heat_level_t *level, const int colour) {
+    const int nx = level->n[0], ny = level->n[1], nz = level->n[2];
+    int y, z;
+
+    #pragma omp parallel for collapse(2) schedule(static)
+    for (z = 0; z < nz; z++) {
+        for (y = 0; y < ny; y++) {
+            const size_t first = LEVEL_INDEX(*level, 0, y, z);
+            float *e = level->correction + first;
+            const float *rhs = level->rhs + first;
+            float diagonal, sum;
+            int x;
+
+            for (x = (colour + y + z) & 1; x < nx; x += 2) {
+                sum = sumNeighbors(level, e + x, x, y, z, &diagonal);
+                e[x] = (rhs[x] + sum) / diagonal;
+            }
+        }
+    }
+}
+
+/* Sum the residuals of the grid's points other than the source face onto
+ * the cells of the first coarse grid. */
+static void restrictGrid(const heat_grid_t *grid, heat_level_t *coarse) {
+    const int nx = grid->nx, ny = grid->ny, nz = grid->nz;
+    const ptrdiff_t strideY = (ptrdiff_t)grid->strideY;
+    const ptrdiff_t strideZ = (ptrdiff_t)grid->strideZ;
+    int cy, cz;
+
+    #pragma omp parallel for collapse(2) schedule(static)
+    for (cz = 0; cz < coarse->n[2]; cz++) {
+        for (cy = 0; cy < coarse->n[1]; cy++) {
+            float *rhs = coarse->rhs + LEVEL_INDEX(*coarse, 0, cy, cz);
+            int cx, x, y, z, neighborCount;
+
+            for (cx = 0; cx < coarse->n[0]; cx++)
+                rhs[cx] = 0.0f;
+            for (z = 2 * cz; z < 2 * cz + 2 && z < nz; z++) {
+                for (y = 2 * cy; y < 2 * cy + 2 && y < ny; y++) {
+                    const float *now = grid->now + GRID_INDEX(*grid, 0, y, z);
+                    const int faces = countRowFaces(grid, y, z);
+
+                    /* Point x is in cell (x - 1) / 2.  The residual is a
+                     * small difference of large sums, so it is taken in
+                     * double. */
+                    for (x = 1; x < nx; x++) {
+                        neighborCount = 6 - faces - (x == nx - 1);
+                        rhs[(x - 1) / 2] += (float)((double)now[x - 1]
+                            + now[x + 1] + now[x - strideY] + now[x + strideY]
+                            + now[x - strideZ] + now[x + strideZ]
+                            - (double)neighborCount * now[x]);
+                    }
+                }
+            }
+        }
+    }
+}
+
+/* Add the corrections of the first coarse grid to the points they cover. */
+static void prolongGrid(heat_grid_t *grid, const heat_level_t *coarse) {
+    const int nx = grid->nx, ny = grid->ny, nz = grid->nz;
+    int y, z;
+
+    #pragma omp parallel for collapse(2) schedule(static)
+    for (z = 0; z < nz; z++) {
+        for (y = 0; y < ny; y++) {
+            float *now = grid->now + GRID_INDEX(*grid, 0, y, z);
+            const float *e = coarse->correction
+                + LEVEL_INDEX(*coarse, 0, y / 2, z / 2);
+            int x;
+
+            for (x = 1; x < nx; x++)
+                now[x] += e[(x - 1) / 2];
+        }
+    }
+}
+
+/* Sum the residuals of a coarse grid's cells onto the cells of the next
+ * coarser grid. */
+static void restrictLevel(const heat_level_t *fine, heat_level_t *coarse) {
+    int cy, cz;
+
+    #pragma omp parallel for collapse(2) schedule(static)
+    for (cz = 0; cz < coarse->n[2]; cz++) {
+        for (cy = 0; cy < coarse->n[1]; cy++) {
+            float *rhs = coarse->rhs + LEVEL_INDEX(*coarse, 0, cy, cz);
+            float diagonal, sum;
+            int cx, x, y, z;
+
+            for (cx = 0; cx < coarse->n[0]; cx++)
+                rhs[cx] = 0.0f;
+            for (z = 2 * cz; z < 2 * cz + 2 && z < fine->n[2]; z++) {
+                for (y = 2 * cy; y < 2 * cy + 2 && y < fine->n[1]; y++) {
+                    const size_t first = LEVEL_INDEX(*fine, 0, y, z);
+                    const float *e = fine->correction + first;
+                    const float *fineRhs = fine->rhs + first;
+
+                    for (x = 0; x < fine->n[0]; x++) {
+                        sum = sumNeighbors(fine, e + x, x, y, z, &diagonal);
+                        rhs[x / 2] += fineRhs[x] + sum - diagonal * e[x];
+                    }
+                }
+            }
+        }
+    }
+}
+
+/* Add the corrections of a coarse grid to the cells of the next finer grid
+ * they cover. */
+static void prolongLevel(heat_level_t *fine, const heat_level_t *coarse) {
+    int y, z;
+
+    #pragma omp parallel for collapse(2) schedule(static)
+    for (z = 0; z < fine->n[2]; z++) {
+        for (y = 0; y < fine->n[1]; y++) {
+            float *e = fine->correction + LEVEL_INDEX(*fine, 0, y, z);
+            const float *coarseE = coarse->correction
+                + LEVEL_INDEX(*coarse, 0, y / 2, z / 2);
+            int x;
+
+            for (x = 0; x < fine->n[0]; x++)
+                e[x] += coarseE[x / 2];
+        }
+    }
+}
+
+/* Solve coarse grid index for its corrections, starting from 0. */
+static void cycleLevel(heat_multigrid_t *multigrid, const int index) {
+    heat_level_t *level = &(multigrid->levels[index]);
+    int sweep;
+
+    memset(level->correction, 0, level->strideZ * (level->n[2] + 2)
+           * sizeof(float));
+
+    if (index == multigrid->levelCount - 1) {
+        for (sweep = 0; sweep < MULTIGRID_COARSEST_SWEEPS; sweep++) {
+            smoothLevel(level, 0);
+            smoothLevel(level, 1);
+        }
+        return;
+    }
+
+    for (sweep = 0; sweep < MULTIGRID_PRE_SWEEPS; sweep++) {
+        smoothLevel(level, 0);
+        smoothLevel(level, 1);
+    }
+    restrictLevel(level, &(multigrid->levels[index + 1]));
+    cycleLevel(multigrid, index + 1);
+    prolongLevel(level, &(multigrid->levels[index + 1]));
+    for (sweep = 0; sweep < MULTIGRID_POST_SWEEPS; sweep++) {
+        smoothLevel(level, 0);
+        smoothLevel(level, 1);
+    }
+}
+
+void cycleMultigrid(heat_multigrid_t *multigrid, heat_grid_t *grid,
+                    heat_residual_t *residual) {
+    int sweep;
+
+    for (sweep = 0; sweep < MULTIGRID_PRE_SWEEPS; sweep++)
+        sweepRedBlack(grid, 1.0f, NULL);
+
+    if (multigrid->levelCount > 0) {
+        restrictGrid(grid, &(multigrid->levels[0]));
+        cycleLevel(multigrid, 0);
+        prolongGrid(grid, &(multigrid->levels[0]));
+    }
+
+    for (sweep = 0; sweep < MULTIGRID_POST_SWEEPS; sweep++)
+        sweepRedBlack(grid, 1.0f,
+                      (sweep == MULTIGRID_POST_SWEEPS - 1) ? residual : NULL);
+}
+
+/* Pair up the fineCount cells along one axis, given how many points each
+ * spans and where its center is; returns the number of coarse cells and
+ * sets their extents, centers and couplings.  sourceCenter is where the
+ * x == 0 face is, or negative on the y and z axes. */
+static int coarsenAxis(const int fineCount, const float *fineExtents,
+                       const double *fineCenters, const double sourceCenter,
+                       float **extents_p, double **centers_p,
+                       float **lowWeights_p, float **highWeights_p) {
+    const int count = (fineCount + 1) / 2;
+    float *extents = (float*)allocate(count * sizeof(float));
+    double *centers = (double*)allocate(count * sizeof(double));
+    float *lowWeights = (float*)allocate(count * sizeof(float));
+    float *highWeights = (float*)allocate(count * sizeof(float));
+    double moment;
+    int i, child;
+
+    for (i = 0; i < count; i++) {
+        extents[i] = 0.0f;
+        moment = 0.0;
+        for (child = 2 * i; child < 2 * i + 2 && child < fineCount; child++) {
+            extents[i] += fineExtents[child];
+            moment += fineExtents[child] * fineCenters[child];
+        }
+        centers[i] = moment / extents[i];
+    }
+
+    for (i = 0; i < count; i++) {
+        highWeights[i] = (i + 1 < count) ?
+            (float)(1.0 / (centers[i + 1] - centers[i])) : 0.0f;
+        if (i > 0)
+            lowWeights[i] = highWeights[i - 1];
+        else
+            lowWeights[i] = (sourceCenter >= 0.0) ?
+                (float)(1.0 / (centers[0] - sourceCenter)) : 0.0f;
+    }
+
+    *extents_p = extents;
+    *centers_p = centers;
+    *lowWeights_p = lowWeights;
+    *highWeights_p = highWeights;
+
+    return count;
+}
+
+void initializeMultigrid(heat_multigrid_t *multigrid,
+                         const heat_grid_t *grid) {
+    /* The points of the grid other than the source face, which are cells of
+     * extent 1 centered at their coordinates. */
+    int counts[3] = {grid->nx - 1, grid->ny, grid->nz};
+    float *extents[3];
+    double *centers[3], *coarseCenters[3];
+    int axis, i;
+
+    for (axis = 0; axis < 3; axis++) {
+        extents[axis] = (float*)allocate((counts[axis] > 0 ? counts[axis] : 1)
+                                         * sizeof(float));
+        centers[axis] = (double*)allocate((counts[axis] > 0 ? counts[axis] : 1)
+                                          * sizeof(double));
+        for (i = 0; i < counts[axis]; i++) {
+            extents[axis][i] = 1.0f;
+            centers[axis][i] = (axis == 0) ? i + 1 : i;
+        }
+    }
+
+    multigrid->levelCount = 0;
+    while (multigrid->levelCount < MULTIGRID_MAX_LEVELS && counts[0] > 0
+           && (counts[0] > 2 || counts[1] > 2 || counts[2] > 2)) {
+        heat_level_t *level = &(multigrid->levels[multigrid->levelCount]);
+
+        for (axis = 0; axis < 3; axis++) {
+            level->n[axis] = coarsenAxis(counts[axis], extents[axis],
+                    centers[axis], (axis == 0) ? 0.0 : -1.0,
+                    &(level->extents[axis]), &(coarseCenters[axis]),
+                    &(level->lowWeights[axis]), &(level->highWeights[axis]));
+            counts[axis] = level->n[axis];
+            if (multigrid->levelCount == 0)
+                free(extents[axis]);
+            free(centers[axis]);
+            extents[axis] = level->extents[axis];
+            centers[axis] = coarseCenters[axis];
+        }
+
+        level->strideY = (size_t)level->n[0] + 2;
+        level->strideZ = level->strideY * ((size_t)level->n[1] + 2);
+        level->correction = (float*)allocate(level->strideZ
+                * ((size_t)level->n[2] + 2) * sizeof(float));
+        level->rhs = (float*)allocate(level->strideZ
+                * ((size_t)level->n[2] + 2) * sizeof(float));
+        multigrid->levelCount++;
+    }
+
+    for (axis = 0; axis < 3; axis++) {
+        if (multigrid->levelCount == 0)
+            free(extents[axis]);
+        free(centers[axis]);
+    }
+}
+
+void freeMultigrid(heat_multigrid_t *multigrid) {
+    int index, axis;
+
+    for (index = 0; index < multigrid->levelCount; index++) {
+        heat_level_t *level = &(multigrid->levels[index]);
+
+        for (axis = 0; axis < 3; axis++) {
+            free(level->extents[axis]);
+            free(level->lowWeights[axis]);
+            free(level->highWeights[axis]);
+        }
+        free(level->correction);
+        free(level->rhs);
+    }
+}
@@ -0,0 +1,94 @@
+/* PROGRAM: Simple Heat netCDF
+ * Steady - solves for the temperatures the time steps converge to.
+ *
+ * Once the temperatures stop changing, every point other than those on the
+ * x == 0 face is the average of its neighbors, as in heat-stencil.h: the
+ * same points, the same ghost points and the same neighbor counts.  Jacobi
+ * time steps take O(N^2) steps to get there on an N-point-wide grid; these
+ * solvers update the grid in place and get there in far fewer sweeps.
+ *
+ * Red-black SOR updates the points whose x + y + z is even, then those whose
+ * x + y + z is odd, each from its neighbors' newest temperatures, moving it
+ * omega times as far as the average would.
+ *
+ * The multigrid V-cycle smooths with red-black Gauss-Seidel, then solves for
+ * the smooth remainder of the error on coarser grids.  The coarse grids are
+ * cell-centered: each coarse cell is a 2 x 2 x 2 block of finer cells (fewer
+ * at the ends), coupled to its neighbors in proportion to the area between
+ * them over the distance between their centers, and to the x == 0 face by
+ * the same rule, so their faces are insulated and held at the same
+ * temperature as the finest grid's.  Residuals are summed onto the coarse
+ * cells and corrections are copied back to every finer cell they cover.
+ *
+ * Both measure the residual the way stepGrid() does: how far each point was
+ * from the average of its neighbors when it was updated in the last sweep.
+ * Sums of neighbors are taken in double, so the residual can fall to about
+ * one rounding step of a float temperature; over-relaxation leaves SOR's a
+ * few times that.  They work on a whole grid, not on a block of one.
+ */
+#ifndef HEAT_STEADY_H
+#define HEAT_STEADY_H
+
+#include "heat-grid.h"
+#include "heat-stencil.h"
+
+/* Red-black Gauss-Seidel sweeps before and after visiting a coarser grid,
+ * and on the coarsest grid. */
+#define MULTIGRID_PRE_SWEEPS 2
+#define MULTIGRID_POST_SWEEPS 2
+#define MULTIGRID_COARSEST_SWEEPS 50
+
+/* Most coarse grids; coarsening stops before this once every dimension is
+ * 2 cells or fewer. */
+#define MULTIGRID_MAX_LEVELS 16
+
+/* One coarse grid. */
+typedef struct {
+    /* Number of cells in x, y and z. */
+    int n[3];
+
+    /* Distance in floats between neighbors in y and in z. */
+    size_t strideY, strideZ;
+
+    /* Corrections to the cells of the finer grid, with a layer of ghost
+     * cells that stay 0, and the residuals they must cancel; indexed as
+     * GRID_INDEX indexes a grid. */
+    float *correction;
+    float *rhs;
+
+    /* For each of x, y and z and each cell along it: how many points of the
+     * finest grid it spans, and its couplings to the cells below and above
+     * (1 / the distance between their centers, or 0). */
+    float *extents[3];
+    float *lowWeights[3];
+    float *highWeights[3];
+} heat_level_t;
+
+typedef struct {
+    /* Number of coarse grids, finest first. */
+    int levelCount;
+    heat_level_t levels[MULTIGRID_MAX_LEVELS];
+} heat_multigrid_t;
+
+/* The over-relaxation factor that makes red-black SOR converge fastest on
+ * this grid, from the slowest-decaying Jacobi mode. */
+float calculateOmega(const heat_grid_t *grid);
+
+/* One red-black SOR sweep over the grid's current temperatures.  Unless
+ * residual is NULL, set it to how much the sweep would have changed them
+ * with omega 1. */
+void sweepRedBlack(heat_grid_t *grid, const float omega,
+                   heat_residual_t *residual);
+
+/* Allocate the coarse grids for a grid. */
+void initializeMultigrid(heat_multigrid_t *multigrid,
+                         const heat_grid_t *grid);
+
+/* One V-cycle over the grid's current temperatures.  Unless residual is
+ * NULL, set it as sweepRedBlack() does for the last sweep. */
+void cycleMultigrid(heat_multigrid_t *multigrid, heat_grid_t *grid,
+                    heat_residual_t *residual);
+
+void freeMultigrid(heat_multigrid_t *multigrid);
+
+#endif
@@ -0,0 +1,296 @@
+/* PROGRAM: Simple Heat netCDF
+ * Stencil - advances the grid through time.
+ */
+
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <omp.h>
+#include "heat-stencil.h"
+
+/* Number of rows in y per tile, so that four planes of a tile fit in
+ * STENCIL_CACHE_BYTES. */
+static int calculateTileRows(const heat_grid_t *grid) {
+    const size_t rows = STENCIL_CACHE_BYTES / (4 * grid->strideY * sizeof(float));
+
+    if (rows < 1)
+        return 1;
+    return (rows > (size_t)grid->ny) ? grid->ny : (int)rows;
+}
+
+/* Update the points of row (y, z) with firstX <= x < endX, skipping the
+ * source face at x == 0 of the whole grid, and add their changes to
+ * sumSquares and maxChange unless sumSquares is NULL. */
+static void stepRow(const heat_grid_t *grid, const int firstX, const int endX,
+                    const int y, const int z, double *sumSquares,
+                    float *maxChange) {
+    const size_t first = GRID_INDEX(*grid, 0, y, z);
+    const ptrdiff_t strideY = (ptrdiff_t)grid->strideY;
+    const ptrdiff_t strideZ = (ptrdiff_t)grid->strideZ;
+    const float *restrict now = grid->now + first;
+    float *restrict next = grid->next + first;
+    const float *restrict inverseCount =
+        grid->inverseCounts[countRowFaces(grid, y, z)];
+    const int startX = (grid->firstX == 0 && firstX < 1) ? 1 : firstX;
+    float rowSum = 0.0f, rowMax;
+    int x;
+
+    if (sumSquares == NULL) {
+        #pragma omp simd
+        for (x = startX; x < endX; x++) {
+            next[x] = (now[x - 1] + now[x + 1]
+                       + now[x - strideY] + now[x + strideY]
+                       + now[x - strideZ] + now[x + strideZ])
+                * inverseCount[x];
+        }
+        return;
+    }
+
+    rowMax = *maxChange;
+    #pragma omp simd reduction(+:rowSum) reduction(max:rowMax)
+    for (x = startX; x < endX; x++) {
+        const float value = (now[x - 1] + now[x + 1]
+                             + now[x - strideY] + now[x + strideY]
+                             + now[x - strideZ] + now[x + strideZ])
+            * inverseCount[x];
+        const float change = fabsf(value - now[x]);
+
+        next[x] = value;
+        rowSum += change * change;
+        rowMax = (change > rowMax) ? change : rowMax;
+    }
+
+    *sumSquares += rowSum;
+    *maxChange = rowMax;
+}
+
+void stepRegion(heat_grid_t *grid, const int firstX, const int endX,
+                const int firstY, const int endY, const int firstZ,
+                const int endZ, heat_residual_t *residual) {
+    const int tileRows = calculateTileRows(grid);
+    const int tileCount = (endY - firstY + tileRows - 1) / tileRows;
+    const int chunkCount = (endZ - firstZ + STENCIL_Z_CHUNK - 1)
+        / STENCIL_Z_CHUNK;
+    double sumSquares = 0.0;
+    float maxChange = 0.0f;
+    int chunk, tile;
+
+    if (endX <= firstX || endY <= firstY || endZ <= firstZ)
+        return;
+
+    #pragma omp parallel for collapse(2) schedule(static) \
+        reduction(+:sumSquares) reduction(max:maxChange)
+    for (chunk = 0; chunk < chunkCount; chunk++) {
+        for (tile = 0; tile < tileCount; tile++) {
+            const int tileFirstY = firstY + tile * tileRows;
+            const int tileEndY =
+                (tileFirstY + tileRows < endY) ? tileFirstY + tileRows : endY;
+            const int chunkFirstZ = firstZ + chunk * STENCIL_Z_CHUNK;
+            const int chunkEndZ = (chunkFirstZ + STENCIL_Z_CHUNK < endZ) ?
+                chunkFirstZ + STENCIL_Z_CHUNK : endZ;
+            int y, z;
+
+            for (z = chunkFirstZ; z < chunkEndZ; z++)
+                for (y = tileFirstY; y < tileEndY; y++)
+                    stepRow(grid, firstX, endX, y, z,
+                            (residual != NULL) ? &sumSquares : NULL,
+                            &maxChange);
+        }
+    }
+
+    if (residual == NULL)
+        return;
+    residual->sumSquares += sumSquares;
+    if (maxChange > residual->maxChange)
+        residual->maxChange = maxChange;
+}
+
+double residualL2(const heat_residual_t *residual, const double pointCount) {
+    return sqrt(residual->sumSquares / pointCount);
+}
+
+void swapGrid(heat_grid_t *grid) {
+    float *swap = grid->now;
+
+    grid->now = grid->next;
+    grid->next = swap;
+}
+
+void stepGrid(heat_grid_t *grid, heat_residual_t *residual) {
+    if (residual != NULL) {
+        residual->sumSquares = 0.0;
+        residual->maxChange = 0.0f;
+    }
+    stepRegion(grid, 0, grid->nx, 0, grid->ny, 0, grid->nz, residual);
+
+    /* advance temperature. */
+    swapGrid(grid);
+}
+
+/* Floats in a row of a tile of up to nx points with a halo of steps points
+ * and ghost points, padded to whole cache lines. */
+static size_t calculateBlockStride(const int nx, const int steps) {
+    const size_t floatsPerLine = GRID_ALIGNMENT / sizeof(float);
+    const int tileNx = (nx < STENCIL_BLOCK_NX) ? nx : STENCIL_BLOCK_NX;
+
+    return ((size_t)tileNx + 2 * steps + 2 + floatsPerLine - 1)
+        / floatsPerLine * floatsPerLine;
+}
+
+void initializeBlocking(heat_blocking_t *blocking, const heat_grid_t *grid,
+                        const int steps) {
+    const int tileNy = (grid->ny < STENCIL_BLOCK_NY) ?
+        grid->ny : STENCIL_BLOCK_NY;
+    const int tileNz = (grid->nz < STENCIL_BLOCK_NZ) ?
+        grid->nz : STENCIL_BLOCK_NZ;
+    void *buffers = NULL;
+    size_t size;
+
+    blocking->steps = steps;
+    blocking->threadCount = omp_get_max_threads();
+    blocking->bufferSize = calculateBlockStride(grid->nx, steps)
+        * ((size_t)tileNy + 2 * steps + 2) * ((size_t)tileNz + 2 * steps + 2);
+    size = 2 * blocking->bufferSize * blocking->threadCount * sizeof(float);
+    if (posix_memalign(&buffers, GRID_ALIGNMENT, size) != 0) {
+        fprintf(stderr, "Could not allocate %lu bytes, exiting!\n",
+                (unsigned long)size);
+        exit(EXIT_FAILURE);
+    }
+    blocking->buffers = (float*)buffers;
+}
+
+/* Copy rows firstY <= y < endY of planes firstZ <= z < endZ of from, with
+ * points firstX <= x < endX, to the same points of to, which may index them
+ * differently; the coordinates are from's. */
+static void copyRows(const heat_grid_t *to, float *toArray,
+                     const heat_grid_t *from, const float *fromArray,
+                     const int firstX, const int endX, const int firstY,
+                     const int endY, const int firstZ, const int endZ) {
+    const int dx = from->firstX - to->firstX;
+    const int dy = from->firstY - to->firstY;
+    const int dz = from->firstZ - to->firstZ;
+    int y, z;
+
+    for (z = firstZ; z < endZ; z++)
+        for (y = firstY; y < endY; y++)
+            memcpy(toArray + GRID_INDEX(*to, firstX + dx, y + dy, z + dz),
+                   fromArray + GRID_INDEX(*from, firstX, y, z),
+                   (size_t)(endX - firstX) * sizeof(float));
+}
+
+/* Advance the tile of points tileX <= x < tileX + STENCIL_BLOCK_NX, and so
+ * on, steps time steps in the buffers, and write the last into grid->next.
+ * Adds the changes of the last step to sumSquares unless it is NULL, and to
+ * maxChange. */
+static void stepTile(const heat_grid_t *grid, float *buffers,
+                     const int steps, const int tileX, const int tileY,
+                     const int tileZ, double *sumSquares, float *maxChange) {
+    const size_t floatsPerLine = GRID_ALIGNMENT / sizeof(float);
+    const int tile[3] = {tileX, tileY, tileZ};
+    const int tileSizes[3] =
+        {STENCIL_BLOCK_NX, STENCIL_BLOCK_NY, STENCIL_BLOCK_NZ};
+    const int sizes[3] = {grid->nx, grid->ny, grid->nz};
+    int ends[3], firsts[3], lasts[3], dim, step, expand, y, z, faces;
+    heat_grid_t view;
+    float *swap;
+
+    /* The tile with its halo, clipped to the grid. */
+    for (dim = 0; dim < 3; dim++) {
+        ends[dim] = (tile[dim] + tileSizes[dim] < sizes[dim]) ?
+            tile[dim] + tileSizes[dim] : sizes[dim];
+        firsts[dim] = (tile[dim] - steps > 0) ? tile[dim] - steps : 0;
+        lasts[dim] = (ends[dim] + steps < sizes[dim]) ?
+            ends[dim] + steps : sizes[dim];
+    }
+
+    /* A grid made of the buffers, in which the tile and its halo are a
+     * block of the whole grid. */
+    view = *grid;
+    view.nx = lasts[0] - firsts[0];
+    view.ny = lasts[1] - firsts[1];
+    view.nz = lasts[2] - firsts[2];
+    view.firstX = grid->firstX + firsts[0];
+    view.firstY = grid->firstY + firsts[1];
+    view.firstZ = grid->firstZ + firsts[2];
+    view.strideY = ((size_t)view.nx + 2 + floatsPerLine - 1) / floatsPerLine
+        * floatsPerLine;
+    view.strideZ = view.strideY * ((size_t)view.ny + 2);
+    view.size = view.strideZ * ((size_t)view.nz + 2);
+    view.now = buffers;
+    view.next = buffers + view.size;
+    for (faces = 0; faces < 5; faces++)
+        view.inverseCounts[faces] = grid->inverseCounts[faces] + firsts[0];
+
+    /* Both buffers start with the temperatures now, and the ghost points and
+     * source face around them, which are never updated. */
+    copyRows(&view, view.now, grid, grid->now, firsts[0] - 1, lasts[0] + 1,
+             firsts[1] - 1, lasts[1] + 1, firsts[2] - 1, lasts[2] + 1);
+    memcpy(view.next, view.now, view.size * sizeof(float));
+
+    /* At each step, update the points whose neighbors are still up to
+     * date: the tile and a halo one point shallower than the step before.
+     * The edges of the grid do not go stale. */
+    for (step = 1; step <= steps; step++) {
+        int lows[3], highs[3];
+
+        expand = steps - step;
+        for (dim = 0; dim < 3; dim++) {
+            lows[dim] = ((tile[dim] - expand > 0) ? tile[dim] - expand : 0)
+                - firsts[dim];
+            highs[dim] = ((ends[dim] + expand < sizes[dim]) ?
+                          ends[dim] + expand : sizes[dim]) - firsts[dim];
+        }
+        for (z = lows[2]; z < highs[2]; z++)
+            for (y = lows[1]; y < highs[1]; y++)
+                stepRow(&view, lows[0], highs[0], y, z,
+                        (step == steps) ? sumSquares : NULL, maxChange);
+
+        swap = view.now;
+        view.now = view.next;
+        view.next = swap;
+    }
+
+    copyRows(grid, grid->next, &view, view.now, tile[0] - firsts[0],
+             ends[0] - firsts[0], tile[1] - firsts[1], ends[1] - firsts[1],
+             tile[2] - firsts[2], ends[2] - firsts[2]);
+}
+
+void stepBlocked(heat_blocking_t *blocking, heat_grid_t *grid,
+                 const int steps, heat_residual_t *residual) {
+    const int tilesX = (grid->nx + STENCIL_BLOCK_NX - 1) / STENCIL_BLOCK_NX;
+    const int tilesY = (grid->ny + STENCIL_BLOCK_NY - 1) / STENCIL_BLOCK_NY;
+    const int tilesZ = (grid->nz + STENCIL_BLOCK_NZ - 1) / STENCIL_BLOCK_NZ;
+    double sumSquares = 0.0;
+    float maxChange = 0.0f;
+    int tx, ty, tz;
+
+    if (steps <= 1) {
+        stepGrid(grid, residual);
+        return;
+    }
+
+    #pragma omp parallel for collapse(3) schedule(static) \
+        reduction(+:sumSquares) reduction(max:maxChange)
+    for (tz = 0; tz < tilesZ; tz++)
+        for (ty = 0; ty < tilesY; ty++)
+            for (tx = 0; tx < tilesX; tx++)
+                stepTile(grid, blocking->buffers + 2 * blocking->bufferSize
+                         * omp_get_thread_num(), steps,
+                         tx * STENCIL_BLOCK_NX, ty * STENCIL_BLOCK_NY,
+                         tz * STENCIL_BLOCK_NZ,
+                         (residual != NULL) ? &sumSquares : NULL, &maxChange);
+
+    if (residual != NULL) {
+        residual->sumSquares = sumSquares;
+        residual->maxChange = maxChange;
+    }
+
+    /* advance temperature. */
+    swapGrid(grid);
+}
+
+void freeBlocking(heat_blocking_t *blocking) {
+    free(blocking->buffers);
+}
@@ -0,0 +1,93 @@
+/* PROGRAM: Simple Heat netCDF
+ * Stencil - advances the grid through time.
+ *
+ * Each time step, every point other than those on the x == 0 face becomes
+ * the average of its neighbors (the 7-point stencil without its center).
+ * The grid is split into tiles of rows in y, each small enough that the
+ * three planes of now it reads and the plane of next it writes stay in
+ * cache while the tile is swept through a run of planes in z.  The tiles are
+ * shared among the OpenMP threads, and each row in x is one SIMD loop with
+ * no branches, thanks to the ghost points.
+ *
+ * When asked, the same loop measures how much the step changed the
+ * temperatures, so the residual costs no extra pass over the grid.
+ *
+ * Several time steps can also be taken at once with temporal blocking, so
+ * the grid streams through memory once per block of steps instead of once
+ * per step.  The grid is split into tiles of STENCIL_BLOCK_NX x
+ * STENCIL_BLOCK_NY x STENCIL_BLOCK_NZ points, and each thread copies a tile
+ * and a halo as deep as the number of steps into its own pair of buffers,
+ * steps it there, the halo shrinking by one point a step as its edge goes
+ * stale, and copies the tile back out.  The halos are updated by more than
+ * one tile, so this does more arithmetic for less memory traffic.
+ */
+#ifndef HEAT_STENCIL_H
+#define HEAT_STENCIL_H
+
+#include "heat-grid.h"
+
+/* Bytes of cache a tile should fit in. */
+#define STENCIL_CACHE_BYTES (256 * 1024)
+
+/* Number of planes in z swept by each tile. */
+#define STENCIL_Z_CHUNK 64
+
+/* Size of the tiles of temporal blocking. */
+#define STENCIL_BLOCK_NX 256
+#define STENCIL_BLOCK_NY 32
+#define STENCIL_BLOCK_NZ 32
+
+/* How much a time step changed the temperatures. */
+typedef struct {
+    /* Sum over the points of the square of the change. */
+    double sumSquares;
+
+    /* Largest change of any point: the L-infinity norm. */
+    float maxChange;
+} heat_residual_t;
+
+/* Buffers for temporal blocking. */
+typedef struct {
+    /* Most time steps per block. */
+    int steps;
+
+    /* Number of floats in each buffer, and two buffers for each thread. */
+    size_t bufferSize;
+    int threadCount;
+    float *buffers;
+} heat_blocking_t;
+
+/* Advance the grid one time step, setting residual to how much it changed
+ * unless it is NULL, then swap now and next. */
+void stepGrid(heat_grid_t *grid, heat_residual_t *residual);
+
+/* Compute next for the points with firstX <= x < endX, firstY <= y < endY
+ * and firstZ <= z < endZ, from now, and add their changes to residual unless it is NULL.  Used
+ * to update the inside of a block while its ghost points are being
+ * exchanged, then its edges. */
+void stepRegion(heat_grid_t *grid, const int firstX, const int endX,
+                const int firstY, const int endY, const int firstZ,
+                const int endZ, heat_residual_t *residual);
+
+/* Allocate the buffers to advance the grid up to steps time steps at a
+ * time. */
+void initializeBlocking(heat_blocking_t *blocking, const heat_grid_t *grid,
+                        const int steps);
+
+/* Advance the grid steps time steps, at most blocking->steps, with temporal
+ * blocking, setting residual to how much the last of them changed it unless
+ * it is NULL, then swap now and next.  The grid must be whole, not a block
+ * of one. */
+void stepBlocked(heat_blocking_t *blocking, heat_grid_t *grid,
+                 const int steps, heat_residual_t *residual);
+
+void freeBlocking(heat_blocking_t *blocking);
+
+/* The root mean square change of the pointCount points: the L2 norm of the
+ * changes, scaled so it does not grow with the grid. */
+double residualL2(const heat_residual_t *residual, const double pointCount);
+
+/* Swap now and next, once next has been computed for every point. */
+void swapGrid(heat_grid_t *grid);
+
+#endif
@@ -10,7 +10,12 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <math.h>
+#include <float.h>
+#include <limits.h>
+#include <unistd.h>
 #include <netcdf.h>
+#include <netcdf_par.h>
 
 /* create macro for exiting if MPI errors occur */
 #define tryMPI(ret, str, rank) \
@@ -24,11 +29,19 @@
 #define FILE_NAME "accel-data.nc"
 
 /* We are writing 1D data: pairs of initial position and final time data,
- * with (mpi_size * num_threads) total pairs. */
-#define NDIMS 1
+ * with a batch of pairs from every rank.  Each rank writes its own slice
+ * of the file with collective parallel NetCDF, at an offset given by the
+ * number of pairs of the ranks before it.
+ *
+ * In sweep mode (-s) the data is 2D instead: the final time for every
+ * initial position and initial velocity of a grid of them.  The rows of
+ * positions are block-distributed across the ranks, and each rank writes
+ * its rows of the grid. */
+#define NDIMS 2
 
 /* Names of things. */
 #define INIT_POS_NAME "initial_position"
+#define INIT_VEL_NAME "initial_velocity"
 #define FINAL_TIME_NAME "final_time"
 #define TEMP_NAME "temperature"
 #define UNITS "units"
@@ -45,7 +58,132 @@
 const double ACCELERATION = -9.81;
 const double VELOCITY_0 = 0.0;
 const double FACTOR = 1e6;
-const int MPI_TAG = 0;
+
+/* Number of fall times a thread takes at a time from the grid */
+#define SOLVE_CHUNK 1024
+
+/* The reference simulation: fall one step at a time from position, with
+ * velocity to begin with, and return the number of steps until the
+ * position is no longer above 0. */
+int fallTimeIterative(double position, double velocity) {
+    int t = 0;
+
+    while (position > 0) {
+        velocity += ACCELERATION;
+        position += velocity;
+        t++;
+    }
+
+    return t;
+}
+
+/* Position after n steps from position and velocity: velocity gains
+ * ACCELERATION before each step, so this is exact arithmetic on the same
+ * sequence. */
+static double positionAfter(const double position, const double velocity,
+        const double n) {
+    return position + n * velocity + ACCELERATION * n * (n + 1) / 2;
+}
+
+/* How far the reference's rounding can carry its position after n steps
+ * from the exact one: each of its 2n additions rounds by half an ulp of a
+ * value no larger than the position or the velocity, and a velocity error
+ * is added again every later step. */
+static double roundingBound(const double position, const double velocity,
+        const double n) {
+    return 2 * DBL_EPSILON * n
+        * (fabs(position) + n * (fabs(velocity) + fabs(ACCELERATION) * n));
+}
+
+/* Solve the fall times from every pair of num_positions positions and
+ * num_velocities velocities, matching fallTimeIterative(): the time from
+ * position i and velocity j goes in times[i * num_velocities + j].
+ *
+ * The number of steps is the smallest n with positionAfter(n) <= 0, so it
+ * is the positive root of that quadratic rounded up, then moved by a step
+ * if the root's own rounding put it on the wrong side.  Where the position
+ * after n - 1 or n steps is so close to 0 that the reference's rounding
+ * could put it on the other side, the reference is run instead.
+ *
+ * Return how many fall times are too long for an int; those are left as
+ * INT_MAX. */
+long solveFallTimes(const double *positions, const long num_positions,
+        const double *velocities, const long num_velocities, int *times) {
+    long i, j;
+    long overflows = 0;
+
+#pragma omp parallel for simd collapse(2) schedule(dynamic, SOLVE_CHUNK) \
+        reduction(+:overflows)
+    for (i = 0; i < num_positions; i++) {
+        for (j = 0; j < num_velocities; j++) {
+            const double position = positions[i];
+            const double velocity = velocities[j];
+            const double b = velocity + ACCELERATION / 2;
+            const double root = (-b
+                    - sqrt(b * b - 2 * ACCELERATION * position))
+                / ACCELERATION;
+            double n = (position > 0) ? ceil(root) : 0;
+            double before, after, bound;
+
+            /* the exact correction, branch-free so it vectorises */
+            n += (n > 0 && positionAfter(position, velocity, n) > 0) ? 1 : 0;
+            n -= (n > 1 && positionAfter(position, velocity, n - 1) <= 0)
+                ? 1 : 0;
+
+            /* mark those too close to call with -1; the reference may
+             * take a step more, so INT_MAX is already too long */
+            before = positionAfter(position, velocity, n - 1);
+            after = positionAfter(position, velocity, n);
+            bound = roundingBound(position, velocity, n);
+            overflows += (n >= INT_MAX) ? 1 : 0;
+            times[i * num_velocities + j] = (n >= INT_MAX) ? INT_MAX
+                : (n > 0 && (fabs(before) <= bound || fabs(after) <= bound))
+                ? -1 : (int)n;
+        }
+    }
+
+#pragma omp parallel for collapse(2) schedule(dynamic)
+    for (i = 0; i < num_positions; i++) {
+        for (j = 0; j < num_velocities; j++) {
+            if (times[i * num_velocities + j] < 0) {
+                times[i * num_velocities + j] =
+                    fallTimeIterative(positions[i], velocities[j]);
+            }
+        }
+    }
+
+    return overflows;
+}
+
+/* Parse a range MIN:MAX into min and max; return 0 if it is not one */
+int parseRange(const char *str, double *min, double *max) {
+    char *end;
+
+    *min = strtod(str, &end);
+    if (end == str || *end != ':') {
+        return 0;
+    }
+    str = end + 1;
+    *max = strtod(str, &end);
+    return end != str && *end == '\0';
+}
+
+/* The i-th of count points spread evenly from min to max */
+double samplePoint(const double min, const double max, const long i,
+        const long count) {
+    return (count > 1) ? min + (max - min) * i / (count - 1) : min;
+}
+
+/* Print how to run the program on rank 0, and exit */
+void printUsageAndExit(const int mpi_rank, char **argv) {
+    if (mpi_rank == 0) {
+        fprintf(stderr, "Usage: %s [-n POSITIONS] [-v] [-q]\n"
+                "       %s -s POSITIONSxVELOCITIES [-p MIN:MAX] "
+                "[-u MIN:MAX] [-v] [-q]\n", argv[0], argv[0]);
+    }
+    MPI_Finalize();
+    exit(EXIT_FAILURE);
+}
 
 /* start program */
 int main(int argc, char **argv) {
@@ -53,28 +191,47 @@ int main(int argc, char **argv) {
     /* declare variables */
     int mpi_rank;
     int mpi_size;
-    int num_threads;
-    double velocity;
-    double position;
-    int t;
-    int i;
-    int j;
+    long num_positions;
+    long num_velocities = 1;
+    long first_pair;
+    long num_pairs;
+    long num_samples;
+    long i;
+    long j;
+    int is_sweep = 0;
+    double pos_min = 0.0, pos_max = 0.0;
+    double vel_min = VELOCITY_0, vel_max = VELOCITY_0;
+    int is_pos_range = 0;
+    int is_vel_range = 0;
+    int is_count = 0;
+    int node_rank;
+    int num_nodes;
+    MPI_Comm node_comm;
     int *final_times;
+    int option;
+    char *end;
+    int is_verifying = 0;
+    int is_quiet = 0;
+    long mismatches = 0;
+    double solve_time;
+    double reference_time;
+    double io_start_time;
+    double io_time;
 
     /* IDs for the netCDF file, dimensions, and variables. */
-    int ncid, init_pos_dimid;
-    int init_pos_varid, final_time_varid;
+    int ncid, init_pos_dimid, init_vel_dimid;
+    int init_pos_varid, init_vel_varid, final_time_varid;
     int dimids[NDIMS];
+    int ndims;
 
     /* The start and count arrays will tell the netCDF library where to
      * write our data */
     size_t start[NDIMS], count[NDIMS];
 
-     /* Program variables to hold the data we will write out. */
-    int *final_time_out;
-
-    /* This program variable holds the initial position coordinates. */
+    /* These program variables hold this rank's initial position
+     * coordinates and the initial velocity coordinates. */
     double *init_pos_coords;
+    double *init_vel_coords;
 
     /* Error handling. */
     int retval;
@@ -96,159 +253,342 @@ int main(int argc, char **argv) {
             mpi_rank
           );
 
-    /* get number of threads */
+    /* parse the options: -n the number of positions per rank (default
+     * the number of threads), -v to check against the reference, -q to not
+     * print the results; or for a sweep, -s the number of positions and
+     * velocities in all, and -p and -u their ranges */
 #pragma omp parallel
     {
 #pragma omp single
         {
-            num_threads = omp_get_num_threads();
+            num_positions = omp_get_num_threads();
+        }
+    }
+    while ((option = getopt(argc, argv, "n:s:p:u:vq")) != -1) {
+        switch (option) {
+            case 'n':
+                is_count = 1;
+                num_positions = strtol(optarg, &end, 10);
+                if (end == optarg || *end != '\0') {
+                    num_positions = 0;
+                }
+                break;
+            case 's':
+                is_sweep = 1;
+                if (sscanf(optarg, "%ldx%ld", &num_pairs, &num_velocities)
+                        != 2) {
+                    num_velocities = 0;
+                }
+                break;
+            case 'p':
+                is_pos_range = 1;
+                if (!parseRange(optarg, &pos_min, &pos_max)) {
+                    num_velocities = 0;
+                }
+                break;
+            case 'u':
+                is_vel_range = 1;
+                if (!parseRange(optarg, &vel_min, &vel_max)) {
+                    num_velocities = 0;
+                }
+                break;
+            case 'v':
+                is_verifying = 1;
+                break;
+            case 'q':
+                is_quiet = 1;
+                break;
+            default:
+                printUsageAndExit(mpi_rank, argv);
         }
     }
 
-    /* allocate memory for array (enough space for each thread) */
-    if ((final_times = malloc(num_threads * sizeof(int))) == NULL) {
-        fprintf(stderr, "Rank %d returned error for malloc, exiting!\n",
-                mpi_rank);
+    /* -n sizes a batch, and -p and -u only range a sweep */
+    if (is_sweep ? is_count : (is_pos_range || is_vel_range)) {
+        printUsageAndExit(mpi_rank, argv);
+    }
+    if (num_positions < 1 || num_velocities < 1
+            || (is_sweep && num_pairs < 1)) {
+        fprintf(stderr, "Rank %d got no positions or a bad range, "
+                "exiting!\n", mpi_rank);
         exit(EXIT_FAILURE);
     }
 
-    /* initialize velocity */
-    velocity = VELOCITY_0;
-
-    /* spawn OpenMP threads */
-#pragma omp parallel private(position, velocity, t)
-    {
-        /* initialize position */
-        position = FACTOR
-            * (mpi_rank * num_threads + omp_get_thread_num());
-
-        /* run the simulation */
-        while (position > 0) {
-            velocity += ACCELERATION;
-            position += velocity;
-            t++;
+    if (is_sweep) {
+        /* this rank's block of the rows of positions */
+        first_pair = num_pairs * mpi_rank / mpi_size;
+        num_positions = num_pairs * (mpi_rank + 1) / mpi_size - first_pair;
+        if (!is_pos_range) {
+            pos_max = FACTOR * (num_pairs - 1);
         }
-
-        /* store the final time in an array */
-        final_times[omp_get_thread_num()] = t;
-
-        /* done spawning threads */
+    } else {
+        /* find this rank's slice of the pairs: the positions of the ranks
+         * before it come first */
+        tryMPI(
+                MPI_Exscan(&num_positions, &first_pair, 1, MPI_LONG, MPI_SUM,
+                    MPI_COMM_WORLD),
+                "MPI_Exscan",
+                mpi_rank
+              );
+        if (mpi_rank == 0) {
+            first_pair = 0;
+        }
+        tryMPI(
+                MPI_Allreduce(&num_positions, &num_pairs, 1, MPI_LONG, MPI_SUM,
+                    MPI_COMM_WORLD),
+                "MPI_Allreduce",
+                mpi_rank
+              );
     }
+    num_samples = num_pairs * num_velocities;
 
-    /* send array to rank 0 */
+    /* count the nodes: the ranks that are first on theirs */
+    tryMPI(
+            MPI_Comm_split_type(MPI_COMM_WORLD, MPI_COMM_TYPE_SHARED, 0,
+                MPI_INFO_NULL, &node_comm),
+            "MPI_Comm_split_type",
+            mpi_rank
+          );
+    tryMPI(
+            MPI_Comm_rank(node_comm, &node_rank),
+            "MPI_Comm_rank",
+            mpi_rank
+          );
+    node_rank = (node_rank == 0);
     tryMPI(
-            MPI_Send(final_times, num_threads, MPI_INT, 0, MPI_TAG,
+            MPI_Allreduce(&node_rank, &num_nodes, 1, MPI_INT, MPI_SUM,
                 MPI_COMM_WORLD),
-            "MPI_Send",
+            "MPI_Allreduce",
             mpi_rank
           );
+    MPI_Comm_free(&node_comm);
 
-    /* rank 0 only */
-    if (mpi_rank == 0) {
-
-        /* Allocate memory for NetCDF arrays */
-        if ((final_time_out = malloc(mpi_size * num_threads
-                * sizeof(int))) == NULL) {
-            fprintf(stderr,
-                "Rank 0 returned error for final_time_out malloc, exiting!\n",
-                mpi_rank);
-            exit(EXIT_FAILURE);
-        }
-        if ((init_pos_coords = malloc(mpi_size * num_threads
-                * sizeof(double))) == NULL) {
-            fprintf(stderr,
-                "Rank 0 returned error for init_pos_coords malloc, exiting!\n",
+    /* allocate memory for this rank's batch; a rank of a sweep may have
+     * no rows, and malloc(0) may return NULL */
+    if ((final_times = malloc(num_positions * num_velocities * sizeof(int)))
+            == NULL && num_positions > 0) {
+        fprintf(stderr, "Rank %d returned error for malloc, exiting!\n",
                 mpi_rank);
-            exit(EXIT_FAILURE);
-        }
+        exit(EXIT_FAILURE);
+    }
+    if ((init_pos_coords = malloc(num_positions * sizeof(double))) == NULL
+            && num_positions > 0) {
+        fprintf(stderr,
+            "Rank %d returned error for init_pos_coords malloc, exiting!\n",
+            mpi_rank);
+        exit(EXIT_FAILURE);
+    }
+    if ((init_vel_coords = malloc(num_velocities * sizeof(double)))
+            == NULL) {
+        fprintf(stderr,
+            "Rank %d returned error for init_vel_coords malloc, exiting!\n",
+            mpi_rank);
+        exit(EXIT_FAILURE);
+    }
 
-        /* Create the netCDF file. */
-        if ((retval = nc_create(FILE_NAME, NC_CLOBBER, &ncid)))
-            ERR(retval);
+    /* Set up the coords variables: the initial positions and velocities */
+    for (i = 0; i < num_positions; i++) {
+        init_pos_coords[i] = is_sweep
+            ? samplePoint(pos_min, pos_max, first_pair + i, num_pairs)
+            : FACTOR * (first_pair + i);
+    }
+    for (j = 0; j < num_velocities; j++) {
+        init_vel_coords[j] = samplePoint(vel_min, vel_max, j,
+                num_velocities);
+    }
 
-        /* Define the dimensions. */
-        if ((retval = nc_def_dim(ncid, INIT_POS_NAME,
-                mpi_size * num_threads, &init_pos_dimid)))
-            ERR(retval);
+    /* run the simulation; the barrier lets the slowest rank's time be the
+     * time for all of them */
+    tryMPI(
+            MPI_Barrier(MPI_COMM_WORLD),
+            "MPI_Barrier",
+            mpi_rank
+          );
+    solve_time = MPI_Wtime();
+    if (solveFallTimes(init_pos_coords, num_positions, init_vel_coords,
+                num_velocities, final_times) > 0) {
+        fprintf(stderr, "Rank %d got a fall time too long for an int, "
+                "exiting!\n", mpi_rank);
+        exit(EXIT_FAILURE);
+    }
+    solve_time = MPI_Wtime() - solve_time;
+
+    /* check against the reference */
+    if (is_verifying) {
+        reference_time = MPI_Wtime();
+#pragma omp parallel for collapse(2) schedule(dynamic) \
+        reduction(+:mismatches)
+        for (i = 0; i < num_positions; i++) {
+            for (j = 0; j < num_velocities; j++) {
+                if (fallTimeIterative(init_pos_coords[i], init_vel_coords[j])
+                        != final_times[i * num_velocities + j]) {
+                    mismatches++;
+                }
+            }
+        }
+        reference_time = MPI_Wtime() - reference_time;
+        tryMPI(
+                MPI_Reduce(mpi_rank == 0 ? MPI_IN_PLACE : &mismatches,
+                    &mismatches, 1, MPI_LONG, MPI_SUM, 0, MPI_COMM_WORLD),
+                "MPI_Reduce",
+                mpi_rank
+              );
+        tryMPI(
+                MPI_Reduce(mpi_rank == 0 ? MPI_IN_PLACE : &reference_time,
+                    &reference_time, 1, MPI_DOUBLE, MPI_MAX, 0,
+                    MPI_COMM_WORLD),
+                "MPI_Reduce",
+                mpi_rank
+              );
+    }
+    tryMPI(
+            MPI_Reduce(mpi_rank == 0 ? MPI_IN_PLACE : &solve_time,
+                &solve_time, 1, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD),
+            "MPI_Reduce",
+            mpi_rank
+          );
 
-        /* Define the coordinate variables. */
-        if ((retval = nc_def_var(ncid, INIT_POS_NAME, NC_DOUBLE, 1,
-                &init_pos_dimid, &init_pos_varid)))
+    /* all ranks write together from here */
+    tryMPI(
+            MPI_Barrier(MPI_COMM_WORLD),
+            "MPI_Barrier",
+            mpi_rank
+          );
+    io_start_time = MPI_Wtime();
+
+    /* Create the netCDF file, shared by all ranks. */
+    if ((retval = nc_create_par(FILE_NAME, NC_CLOBBER | NC_NETCDF4,
+            MPI_COMM_WORLD, MPI_INFO_NULL, &ncid)))
+        ERR(retval);
+
+    /* Define the dimensions. */
+    if ((retval = nc_def_dim(ncid, INIT_POS_NAME, num_pairs,
+            &init_pos_dimid)))
+        ERR(retval);
+    if (is_sweep && (retval = nc_def_dim(ncid, INIT_VEL_NAME,
+            num_velocities, &init_vel_dimid)))
+        ERR(retval);
+
+    /* Define the coordinate variables. */
+    if ((retval = nc_def_var(ncid, INIT_POS_NAME, NC_DOUBLE, 1,
+            &init_pos_dimid, &init_pos_varid)))
+        ERR(retval);
+
+    /* Assign units attributes to coordinate variables */
+    if ((retval = nc_put_att_text(ncid, init_pos_varid, UNITS,
+            strlen(UNITS), UNITS)))
+        ERR(retval);
+    if (is_sweep) {
+        if ((retval = nc_def_var(ncid, INIT_VEL_NAME, NC_DOUBLE, 1,
+                &init_vel_dimid, &init_vel_varid)))
             ERR(retval);
-
-        /* Assign units attributes to coordinate variables */
-        if ((retval = nc_put_att_text(ncid, init_pos_varid, UNITS,
+        if ((retval = nc_put_att_text(ncid, init_vel_varid, UNITS,
                 strlen(UNITS), UNITS)))
             ERR(retval);
+    }
 
-        /* The dimids array is used to pass the dimids of the dimensions
-         * of the netCDF variables. */
-        dimids[0] = init_pos_dimid;
-
-        /* Define the netCDF variable for the final time data. */
-        if ((retval = nc_def_var(ncid, FINAL_TIME_NAME, NC_INT, NDIMS,
-                dimids, &final_time_varid)))
-            ERR(retval);
-
-        /* Assign units attributes to the netCDF final time variable. */
-        if ((retval = nc_put_att_text(ncid, final_time_varid, UNITS,
-                strlen(UNITS), UNITS)))
-            ERR(retval);
+    /* The dimids array is used to pass the dimids of the dimensions
+     * of the netCDF variables. */
+    dimids[0] = init_pos_dimid;
+    ndims = 1;
+    if (is_sweep) {
+        dimids[ndims++] = init_vel_dimid;
+    }
 
-        /* End define mode */
-        if ((retval = nc_enddef(ncid)))
+    /* Define the netCDF variable for the final time data. */
+    if ((retval = nc_def_var(ncid, FINAL_TIME_NAME, NC_INT, ndims,
+            dimids, &final_time_varid)))
+        ERR(retval);
+
+    /* Assign units attributes to the netCDF final time variable. */
+    if ((retval = nc_put_att_text(ncid, final_time_varid, UNITS,
+            strlen(UNITS), UNITS)))
+        ERR(retval);
+
+    /* End define mode */
+    if ((retval = nc_enddef(ncid)))
+        ERR(retval);
+
+    /* Every rank writes each variable once, all together */
+    if ((retval = nc_var_par_access(ncid, init_pos_varid, NC_COLLECTIVE)))
+        ERR(retval);
+    if ((retval = nc_var_par_access(ncid, final_time_varid,
+            NC_COLLECTIVE)))
+        ERR(retval);
+
+    /* Rank 0 writes the velocities; the other ranks join in with none */
+    if (is_sweep) {
+        if ((retval = nc_var_par_access(ncid, init_vel_varid,
+                NC_COLLECTIVE)))
             ERR(retval);
-
-        /* Set up the coords variable */
-        for (i = 0; i < mpi_size; i++) {
-            for (j = 0; j < num_threads; j++) {
-                init_pos_coords[i*num_threads+j] =
-                    FACTOR * (i*num_threads+j);
-            }
-        }
-
-        /* Write the coordinate variable data. */
-        if ((retval = nc_put_var_double(ncid, init_pos_varid,
-                &init_pos_coords[0])))
+        start[0] = 0;
+        count[0] = (mpi_rank == 0) ? num_velocities : 0;
+        if ((retval = nc_put_vara_double(ncid, init_vel_varid, start, count,
+                init_vel_coords)))
             ERR(retval);
+    }
 
-        count[0] = mpi_size * num_threads;
-        start[0] = 0;
+    /* These settings tell netCDF to write this rank's slice */
+    start[0] = first_pair;
+    count[0] = num_positions;
+    start[1] = 0;
+    count[1] = num_velocities;
 
-        /* receive array from each process */
-        for (i = 0; i < mpi_size; i++) {
-            tryMPI(
-                    MPI_Recv(final_times, num_threads, MPI_INT, i,
-                        MPI_TAG, MPI_COMM_WORLD, MPI_STATUS_IGNORE),
-                    "MPI_Recv",
-                    mpi_rank
-                  );
+    /* Write the coordinate variable data. */
+    if ((retval = nc_put_vara_double(ncid, init_pos_varid, start, count,
+            init_pos_coords)))
+        ERR(retval);
 
-            /* write out results */
-            for (j = 0; j < num_threads; j++) {
+    /* write out results */
+    if ((retval = nc_put_vara_int(ncid, final_time_varid, start, count,
+            final_times)))
+        ERR(retval);
 
-                final_time_out[i*num_threads+j] =
-                    final_times[j];
+    /* Close the netCDF file. */
+    if ((retval = nc_close(ncid)))
+        ERR(retval);
 
-                if ((retval = nc_put_vara_int(ncid, final_time_varid,
-                        start, count, &final_time_out[0])))
-                    ERR(retval);
+    /* the slowest rank's time is the time to write the file */
+    io_time = MPI_Wtime() - io_start_time;
+    tryMPI(
+            MPI_Reduce(mpi_rank == 0 ? MPI_IN_PLACE : &io_time, &io_time, 1,
+                MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD),
+            "MPI_Reduce",
+            mpi_rank
+          );
 
-                printf("%f %d\n",
-                        FACTOR * (i*num_threads+j),
-                        final_times[j]);
+    /* each rank prints its own results; lines of different ranks may
+     * arrive in any order */
+    if (!is_quiet) {
+        for (i = 0; i < num_positions; i++) {
+            if (is_sweep) {
+                for (j = 0; j < num_velocities; j++) {
+                    printf("%f %f %d\n", init_pos_coords[i],
+                            init_vel_coords[j],
+                            final_times[i * num_velocities + j]);
+                }
+            } else {
+                printf("%f %d\n", init_pos_coords[i], final_times[i]);
             }
         }
+    }
 
-        /* Close the netCDF file. */
-        if ((retval = nc_close(ncid)))
-            ERR(retval);
-
-        /* Free memory for NetCDF arrays */
-        free(init_pos_coords);
-        free(final_time_out);
+    if (mpi_rank == 0) {
+        fprintf(stderr, "Solved %ld fall times in %f seconds: %e per second "
+                "per node over %d nodes\n", num_samples, solve_time,
+                num_samples / solve_time / num_nodes, num_nodes);
+        if (is_verifying) {
+            fprintf(stderr, "Reference took %f seconds; %ld mismatches\n",
+                    reference_time, mismatches);
+        }
+        fprintf(stderr, "Wrote %ld pairs from %d ranks in %f seconds\n",
+                num_samples, mpi_size, io_time);
     }
 
+    /* Free memory for NetCDF arrays */
+    free(init_pos_coords);
+    free(init_vel_coords);
+
     /* free memory for array */
     free(final_times);
 
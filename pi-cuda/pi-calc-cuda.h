@@ -1 +1,12 @@
+/* Implemented by pi-cuda-1.cu and pi-cuda-2.cu (CUDA) and by pi-cuda-host.c
+ * (OpenMP, for nodes without a GPU).  Each backend sums the areas itself, so
+ * only the total area is returned to the caller. */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 void calculateArea(const int numRects, double *area);
+
+#ifdef __cplusplus
+}
+#endif
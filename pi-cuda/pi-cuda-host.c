@@ -0,0 +1,24 @@
+/* Pi - host version of the CUDA kernels - uses OpenMP threads and SIMD lanes
+ * instead of a GPU, so the CUDA programs can be built and run on nodes
+ * without one
+ */
+#include <float.h> /* DBL_EPSILON */
+#include <math.h> /* sqrt() */
+#include "pi-calc-cuda.h" /* calculateArea() */
+
+void calculateArea(const int numRects, double *area) {
+  const double width = (1.0 / numRects);
+  double sum = 0.0;
+  int i = 0;
+
+#pragma omp parallel for simd reduction(+:sum)
+  for (i = 0; i < numRects; i++) {
+    const double x = (i * width);
+    const double heightSq = (1.0 - (x * x));
+
+    /* Prevent nan value for sqrt() */
+    sum += (width * sqrt((heightSq < DBL_EPSILON) ? (0.0) : (heightSq)));
+  }
+
+  (*area) = sum;
+}
@@ -0,0 +1,11 @@
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void getUserOptions(int argc, char **argv, int *numRects);
+
+void calculateAndPrintPi(const double area);
+
+#ifdef __cplusplus
+}
+#endif
@@ -1,5 +1,6 @@
 #include <float.h> /* DBL_EPSILON and LDBL_DIG */
 #include <math.h>  /* sqrt() */
+#include "pi-calc.h" /* calculateHeight() */
 
 void calculateHeight(const int i, const double width, double *height) {
   const double x = (i * width);
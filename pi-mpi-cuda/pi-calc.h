@@ -1 +1,9 @@
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 void calculateHeight(const int i, const double width, double *height);
+
+#ifdef __cplusplus
+}
+#endif
@@ -2,54 +2,129 @@
  * Author: Aaron Weeden, Shodor, May 2015
  */
 #include <stdio.h> /* fprintf() */
+#include <stdlib.h> /* exit(), EXIT_FAILURE */
 #include <float.h> /* DBL_EPSILON() */
 #include <math.h> /* sqrt() */
+#include "pi-calc-cuda.h" /* calculateArea() */
 
+/* Must be a power of 2 for the tree reduction in shared memory */
+#define THREADS_PER_BLOCK 256
+
+/* Most blocks in a one-dimensional grid on older GPUs; the threads stride
+ * through any further rectangles */
+#define MAX_BLOCKS 65535
+
+/* Each thread calculates the area of every rectangle it strides to, then the
+ * threads of each block sum their areas in shared memory and write one area
+ * per block */
 __global__ void calculateAreas(const int numRects, const double width,
-    double *dev_areas) {
-  const int threadId = threadIdx.x;
-  const double x = (threadId * width);
-  const double heightSq = (1.0 - (x * x));
-  const double height =
+    double *dev_blockAreas) {
+  __shared__ double areas[THREADS_PER_BLOCK];
+  const int numThreads = (gridDim.x * blockDim.x);
+  double sum = 0.0;
+  double x = 0.0;
+  double heightSq = 0.0;
+  long long rectId = 0;
+  int stride = 0;
+
+  for (rectId = (blockIdx.x * blockDim.x) + threadIdx.x; rectId < numRects;
+      rectId += numThreads) {
+    x = (rectId * width);
+    heightSq = (1.0 - (x * x));
     /* Prevent nan value for sqrt() */
-    (heightSq < DBL_EPSILON) ? (0.0) : (sqrt(heightSq));
+    sum += (heightSq < DBL_EPSILON) ? (0.0) : (width * sqrt(heightSq));
+  }
+  areas[threadIdx.x] = sum;
+  __syncthreads();
 
-  if (threadId < numRects) {
-    dev_areas[threadId] = (width * height);
+  for (stride = (blockDim.x / 2); stride > 0; stride /= 2) {
+    if (threadIdx.x < stride) {
+      areas[threadIdx.x] += areas[threadIdx.x + stride];
+    }
+    __syncthreads();
+  }
+
+  if (threadIdx.x == 0) {
+    dev_blockAreas[blockIdx.x] = areas[0];
   }
 }
 
-void calculateArea(const int numRects, double *area) {
-  double *areas = (double*)malloc(numRects * sizeof(double));
-  double *dev_areas;
+/* A single block sums the per-block areas into one area */
+__global__ void sumAreas(const int numAreas, const double *dev_areas,
+    double *dev_area) {
+  __shared__ double areas[THREADS_PER_BLOCK];
+  double sum = 0.0;
   int i = 0;
+  int stride = 0;
+
+  for (i = threadIdx.x; i < numAreas; i += blockDim.x) {
+    sum += dev_areas[i];
+  }
+  areas[threadIdx.x] = sum;
+  __syncthreads();
+
+  for (stride = (blockDim.x / 2); stride > 0; stride /= 2) {
+    if (threadIdx.x < stride) {
+      areas[threadIdx.x] += areas[threadIdx.x + stride];
+    }
+    __syncthreads();
+  }
+
+  if (threadIdx.x == 0) {
+    (*dev_area) = areas[0];
+  }
+}
+
+void calculateArea(const int numRects, double *area) {
+  const int numBlocksNeeded =
+    ((numRects + THREADS_PER_BLOCK - 1) / THREADS_PER_BLOCK);
+  const int numBlocks =
+    (numBlocksNeeded < MAX_BLOCKS) ? (numBlocksNeeded) : (MAX_BLOCKS);
+  double *dev_blockAreas;
+  double *dev_area;
   cudaError_t err;
 
-  if (areas == NULL) {
-    fprintf(stderr, "malloc failed!\n");
+  err = cudaMalloc((void**)&dev_blockAreas, (numBlocks * sizeof(double)));
+
+  if (err != cudaSuccess) {
+    fprintf(stderr, "cudaMalloc failed: %s\n", cudaGetErrorString(err));
+    exit(EXIT_FAILURE);
   }
 
-  err = cudaMalloc((void**)&dev_areas, (numRects * sizeof(double)));
+  err = cudaMalloc((void**)&dev_area, sizeof(double));
 
   if (err != cudaSuccess) {
     fprintf(stderr, "cudaMalloc failed: %s\n", cudaGetErrorString(err));
+    exit(EXIT_FAILURE);
   }
 
-  calculateAreas<<<1, numRects>>>(numRects, (1.0 / numRects), dev_areas);
+  calculateAreas<<<numBlocks, THREADS_PER_BLOCK>>>(numRects,
+    (1.0 / numRects), dev_blockAreas);
 
-  err = cudaMemcpy(areas, dev_areas, (numRects * sizeof(double)),
-    cudaMemcpyDeviceToHost);
+  err = cudaGetLastError();
 
   if (err != cudaSuccess) {
-    fprintf(stderr, "cudaMalloc failed: %s\n", cudaGetErrorString(err));
+    fprintf(stderr, "calculateAreas failed: %s\n", cudaGetErrorString(err));
+    exit(EXIT_FAILURE);
   }
 
-  (*area) = 0.0;
-  for (i = 0; i < numRects; i++) {
-    (*area) += areas[i];
+  sumAreas<<<1, THREADS_PER_BLOCK>>>(numBlocks, dev_blockAreas, dev_area);
+
+  err = cudaGetLastError();
+
+  if (err != cudaSuccess) {
+    fprintf(stderr, "sumAreas failed: %s\n", cudaGetErrorString(err));
+    exit(EXIT_FAILURE);
+  }
+
+  err = cudaMemcpy(area, dev_area, sizeof(double), cudaMemcpyDeviceToHost);
+
+  if (err != cudaSuccess) {
+    fprintf(stderr, "cudaMemcpy failed: %s\n", cudaGetErrorString(err));
+    exit(EXIT_FAILURE);
   }
 
-  cudaFree(dev_areas);
+  cudaFree(dev_area);
 
-  free(areas);
+  cudaFree(dev_blockAreas);
 }
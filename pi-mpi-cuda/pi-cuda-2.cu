@@ -2,67 +2,137 @@
  * Author: Aaron Weeden, Shodor, May 2015
  */
 #include <stdio.h> /* fprintf() */
+#include <stdlib.h> /* exit(), EXIT_FAILURE */
 #include <float.h> /* DBL_EPSILON and LDBL_DIG */
 #include <math.h> /* sqrt() */
+#include "pi-calc-cuda.h" /* calculateArea() */
 
+/* Must be a power of 2 for the tree reduction in shared memory */
+#define THREADS_PER_BLOCK 256
+
+/* Most blocks along one dimension of a grid on older GPUs; more blocks than
+ * this are spread over the y dimension */
+#define MAX_GRID_DIM 65535
+
+/* Each thread calculates the area of one rectangle, then the threads of each
+ * block sum their areas in shared memory and write one area per block */
 __global__ void calculateAreas(const int numRects, const double width,
-    double *dev_areas) {
+    double *dev_blockAreas) {
+  __shared__ double areas[THREADS_PER_BLOCK];
   const int blockId = (blockIdx.x) +
     (blockIdx.y * gridDim.x) +
     (blockIdx.z * gridDim.x * gridDim.y);
-  const int threadId = blockId * (blockDim.x * blockDim.y * blockDim.z) +
-    (threadIdx.x) +
+  const int threadIdInBlock = (threadIdx.x) +
     (threadIdx.y * blockDim.x) +
     (threadIdx.z * (blockDim.x * blockDim.y));
+  const int threadsPerBlock = (blockDim.x * blockDim.y * blockDim.z);
+  const long long threadId =
+    ((long long)blockId * threadsPerBlock) + threadIdInBlock;
   const double x = (threadId * width);
   const double heightSq = (1.0 - (x * x));
   /* Prevent nan value for sqrt() */
   const double height = (heightSq < DBL_EPSILON) ? (0.0) : (sqrt(heightSq));
+  int stride = 0;
+
+  areas[threadIdInBlock] = (threadId < numRects) ? (width * height) : (0.0);
+  __syncthreads();
+
+  for (stride = (threadsPerBlock / 2); stride > 0; stride /= 2) {
+    if (threadIdInBlock < stride) {
+      areas[threadIdInBlock] += areas[threadIdInBlock + stride];
+    }
+    __syncthreads();
+  }
+
+  if (threadIdInBlock == 0) {
+    dev_blockAreas[blockId] = areas[0];
+  }
+}
+
+/* A single block sums the per-block areas into one area */
+__global__ void sumAreas(const int numAreas, const double *dev_areas,
+    double *dev_area) {
+  __shared__ double areas[THREADS_PER_BLOCK];
+  double sum = 0.0;
+  int i = 0;
+  int stride = 0;
+
+  for (i = threadIdx.x; i < numAreas; i += blockDim.x) {
+    sum += dev_areas[i];
+  }
+  areas[threadIdx.x] = sum;
+  __syncthreads();
+
+  for (stride = (blockDim.x / 2); stride > 0; stride /= 2) {
+    if (threadIdx.x < stride) {
+      areas[threadIdx.x] += areas[threadIdx.x + stride];
+    }
+    __syncthreads();
+  }
 
-  if (threadId < numRects) {
-    dev_areas[threadId] = (width * height);
+  if (threadIdx.x == 0) {
+    (*dev_area) = areas[0];
   }
 }
 
 void calculateArea(const int numRects, double *area) {
-  const int gridDimX = 1;
-  const int gridDimY = 1;
+  const int numBlocksNeeded =
+    ((numRects + THREADS_PER_BLOCK - 1) / THREADS_PER_BLOCK);
+  const int gridDimX =
+    (numBlocksNeeded < MAX_GRID_DIM) ? (numBlocksNeeded) : (MAX_GRID_DIM);
+  const int gridDimY = ((numBlocksNeeded + gridDimX - 1) / gridDimX);
   const int gridDimZ = 1;
-  const int blockDimX = 1;
+  const int blockDimX = THREADS_PER_BLOCK;
   const int blockDimY = 1;
-  const int blockDimZ = numRects;
+  const int blockDimZ = 1;
   const dim3 dimGrid(gridDimX, gridDimY, gridDimZ);
   const dim3 dimBlock(blockDimX, blockDimY, blockDimZ);
-  double *areas = (double*)malloc(numRects * sizeof(double));
-  double *dev_areas;
+  const int numBlocks = (gridDimX * gridDimY * gridDimZ);
+  double *dev_blockAreas;
+  double *dev_area;
   cudaError_t err;
-  int i = 0;
 
-  if (areas == NULL) {
-    fprintf(stderr, "malloc failed!\n");
+  err = cudaMalloc((void**)&dev_blockAreas, (numBlocks * sizeof(double)));
+
+  if (err != cudaSuccess) {
+    fprintf(stderr, "cudaMalloc failed: %s\n", cudaGetErrorString(err));
+    exit(EXIT_FAILURE);
   }
 
-  err = cudaMalloc((void**)&dev_areas, (numRects * sizeof(double)));
+  err = cudaMalloc((void**)&dev_area, sizeof(double));
 
   if (err != cudaSuccess) {
     fprintf(stderr, "cudaMalloc failed: %s\n", cudaGetErrorString(err));
+    exit(EXIT_FAILURE);
   }
 
-  calculateAreas<<<dimGrid, dimBlock>>>(numRects, (1.0 / numRects), dev_areas);
+  calculateAreas<<<dimGrid, dimBlock>>>(numRects, (1.0 / numRects),
+    dev_blockAreas);
 
-  err = cudaMemcpy(areas, dev_areas, (numRects * sizeof(double)),
-    cudaMemcpyDeviceToHost);
+  err = cudaGetLastError();
 
   if (err != cudaSuccess) {
-    fprintf(stderr, "cudaMalloc failed: %s\n", cudaGetErrorString(err));
+    fprintf(stderr, "calculateAreas failed: %s\n", cudaGetErrorString(err));
+    exit(EXIT_FAILURE);
   }
 
-  (*area) = 0.0;
-  for (i = 0; i < numRects; i++) {
-    (*area) += areas[i];
+  sumAreas<<<1, THREADS_PER_BLOCK>>>(numBlocks, dev_blockAreas, dev_area);
+
+  err = cudaGetLastError();
+
+  if (err != cudaSuccess) {
+    fprintf(stderr, "sumAreas failed: %s\n", cudaGetErrorString(err));
+    exit(EXIT_FAILURE);
+  }
+
+  err = cudaMemcpy(area, dev_area, sizeof(double), cudaMemcpyDeviceToHost);
+
+  if (err != cudaSuccess) {
+    fprintf(stderr, "cudaMemcpy failed: %s\n", cudaGetErrorString(err));
+    exit(EXIT_FAILURE);
   }
 
-  cudaFree(dev_areas);
+  cudaFree(dev_area);
 
-  free(areas);
+  cudaFree(dev_blockAreas);
 }
@@ -2,6 +2,7 @@
 #include <stdlib.h> /* atoi(), exit(), EXIT_FAILURE */
 #include <stdio.h>  /* fprintf(), printf() */
 #include <float.h>  /* LDBL_DIG */
+#include "pi-io.h" /* getUserOptions(), calculateAndPrintPi() */
 
 void getUserOptions(int argc, char **argv, int *numRects) {
   char c;
@@ -0,0 +1,22 @@
+/* Launch shape shared by pi-mpi-cuda.cu and pi-mpi-cuda-host.c.  Each of the
+ * blocks of THREADS_PER_BLOCK threads strides through the rectangles and
+ * tree-reduces its threads' areas into one area per block, then a second pass
+ * sums the per-block areas, so the scratch memory is O(blocks) rather than
+ * O(myNumRects). */
+
+/* Must be a power of 2 for the tree reductions */
+#define THREADS_PER_BLOCK 256
+
+/* Enough blocks to fill a GPU; any further rectangles are covered by the
+ * threads striding through them */
+#define MAX_BLOCKS 1024
+
+static int calculateNumBlocks(const int myNumRects) {
+  const int numBlocks =
+    ((myNumRects + THREADS_PER_BLOCK - 1) / THREADS_PER_BLOCK);
+
+  if (numBlocks < 1) {
+    return 1;
+  }
+  return (numBlocks < MAX_BLOCKS) ? (numBlocks) : (MAX_BLOCKS);
+}
@@ -0,0 +1,78 @@
+/* Pi - host version of the MPI + CUDA kernel - uses OpenMP threads and SIMD
+ * lanes instead of a GPU, so the MPI + CUDA program can be built and run on
+ * nodes without one.  It follows the same algorithm as pi-mpi-cuda.cu: each
+ * OpenMP iteration plays one CUDA block, whose SIMD lanes play its threads.
+ */
+#include <stdio.h> /* fprintf() */
+#include <stdlib.h> /* malloc(), free() */
+#include <float.h> /* DBL_EPSILON */
+#include <math.h> /* sqrt() */
+#include "pi-mpi-cuda.h" /* calculateMyArea() */
+#include "pi-mpi-cuda-grid.h" /* THREADS_PER_BLOCK, calculateNumBlocks() */
+
+/* Sum a block's areas, halving the number of active lanes each step */
+static double reduceBlock(double *areas) {
+  int stride = 0;
+  int lane = 0;
+
+  for (stride = (THREADS_PER_BLOCK / 2); stride > 0; stride /= 2) {
+#pragma omp simd
+    for (lane = 0; lane < stride; lane++) {
+      areas[lane] += areas[lane + stride];
+    }
+  }
+
+  return areas[0];
+}
+
+void calculateMyArea(const int myNumRects, const double width,
+    const int myDispl, double *area) {
+  const int numBlocks = calculateNumBlocks(myNumRects);
+  const int numThreads = (numBlocks * THREADS_PER_BLOCK);
+  double *blockAreas = (double*)malloc(numBlocks * sizeof(double));
+  double areas[THREADS_PER_BLOCK];
+  int blockId = 0;
+  int first = 0;
+  int lane = 0;
+
+  if (blockAreas == NULL) {
+    fprintf(stderr, "malloc failed!\n");
+    exit(EXIT_FAILURE);
+  }
+
+#pragma omp parallel for private(areas, first, lane)
+  for (blockId = 0; blockId < numBlocks; blockId++) {
+    for (lane = 0; lane < THREADS_PER_BLOCK; lane++) {
+      areas[lane] = 0.0;
+    }
+
+    /* Each lane strides through the rectangles like a thread of the grid */
+    for (first = (blockId * THREADS_PER_BLOCK); first < myNumRects;
+        first += numThreads) {
+#pragma omp simd
+      for (lane = 0; lane < THREADS_PER_BLOCK; lane++) {
+        const int i = (first + lane);
+        const double x = ((myDispl + i) * width);
+        const double heightSq = (1.0 - (x * x));
+
+        /* Prevent nan value for sqrt() */
+        areas[lane] += (i < myNumRects) ?
+          (width * sqrt((heightSq < DBL_EPSILON) ? (0.0) : (heightSq))) :
+          (0.0);
+      }
+    }
+
+    blockAreas[blockId] = reduceBlock(areas);
+  }
+
+  /* Second pass, as sumAreas() does with a single block */
+  for (lane = 0; lane < THREADS_PER_BLOCK; lane++) {
+    areas[lane] = 0.0;
+  }
+  for (blockId = 0; blockId < numBlocks; blockId++) {
+    areas[blockId % THREADS_PER_BLOCK] += blockAreas[blockId];
+  }
+  (*area) = reduceBlock(areas);
+
+  free(blockAreas);
+}
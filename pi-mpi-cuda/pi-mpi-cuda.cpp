@@ -13,7 +13,7 @@
 #include <mpi.h> /* MPI_Finalize() */
 #include "pi-io.h" /* getUserOptions(), calculateAndPrintPi() */
 #include "pi-mpi.h" /* setupMPI(), distributeWork() */
-#include "pi-mpi-cuda.h" /* calculateArea() */
+#include "pi-mpi-cuda.h" /* calculateMyArea() */
 #include "pi-sync-data-2.h" /* syncData() */
 
 /************************
@@ -33,7 +33,7 @@ int main(int argc, char **argv) {
 
   distributeWork(numRects, myRank, numProcs, &myNumRects, &myDispl);
 
-  calculateArea(myNumRects, (1.0 / numRects), myDispl, &area);
+  calculateMyArea(myNumRects, (1.0 / numRects), myDispl, &area);
 
   syncData(&area);
 
@@ -1,66 +1,119 @@
 #include <stdio.h> /* fprintf() */
+#include <stdlib.h> /* exit(), EXIT_FAILURE */
 #include <float.h> /* DBL_EPSILON and LDBL_DIG */
 #include <math.h> /* sqrt() */
+#include "pi-mpi-cuda.h" /* calculateMyArea() */
+#include "pi-mpi-cuda-grid.h" /* THREADS_PER_BLOCK, calculateNumBlocks() */
 
+/* Sum the areas of a block's threads in shared memory, halving the number of
+ * active threads each step; thread 0 is left holding the block's area */
+__device__ void reduceBlock(double *areas) {
+  int stride = 0;
+
+  __syncthreads();
+  for (stride = (THREADS_PER_BLOCK / 2); stride > 0; stride /= 2) {
+    if (threadIdx.x < stride) {
+      areas[threadIdx.x] += areas[threadIdx.x + stride];
+    }
+    __syncthreads();
+  }
+}
+
+/* Each thread strides through the rectangles by the total number of threads,
+ * so any number of rectangles can be covered by a fixed-size grid */
 __global__ void calculateAreas(const int myNumRects, const double width,
-    const int myDispl, double *dev_areas) {
-  const int blockId = (blockIdx.x) +
-    (blockIdx.y * gridDim.x) +
-    (blockIdx.z * gridDim.x * gridDim.y);
-  const int threadId = blockId * (blockDim.x * blockDim.y * blockDim.z) +
-    (threadIdx.x) +
-    (threadIdx.y * blockDim.x) +
-    (threadIdx.z * (blockDim.x * blockDim.y));
-  const double x = ((myDispl + threadId) * width);
-  const double heightSq = (1.0 - (x * x));
-  /* Prevent nan value for sqrt() */
-  const double height = (heightSq < DBL_EPSILON) ? (0.0) : (sqrt(heightSq));
-
-  if (threadId < (myDispl + myNumRects)) {
-    dev_areas[threadId] = (width * height);
+    const int myDispl, double *dev_blockAreas) {
+  __shared__ double areas[THREADS_PER_BLOCK];
+  const int threadId = (blockIdx.x * blockDim.x) + threadIdx.x;
+  const int numThreads = (gridDim.x * blockDim.x);
+  double sum = 0.0;
+  double x = 0.0;
+  double heightSq = 0.0;
+  int i = 0;
+
+  for (i = threadId; i < myNumRects; i += numThreads) {
+    x = ((myDispl + i) * width);
+    heightSq = (1.0 - (x * x));
+
+    /* Prevent nan value for sqrt() */
+    sum += (width * sqrt((heightSq < DBL_EPSILON) ? (0.0) : (heightSq)));
+  }
+  areas[threadIdx.x] = sum;
+
+  reduceBlock(areas);
+
+  if (threadIdx.x == 0) {
+    dev_blockAreas[blockIdx.x] = areas[0];
   }
 }
 
-void calculateArea(const int myNumRects, const double width, const int myDispl,
-    double *area) {
-  const int gridDimX = 1;
-  const int gridDimY = 1;
-  const int gridDimZ = 1;
-  const int blockDimX = 1;
-  const int blockDimY = 1;
-  const int blockDimZ = myNumRects;
-  const dim3 dimGrid(gridDimX, gridDimY, gridDimZ);
-  const dim3 dimBlock(blockDimX, blockDimY, blockDimZ);
-  double *areas = (double*)malloc(myNumRects * sizeof(double));
-  double *dev_areas;
-  cudaError_t err;
+/* A single block sums the per-block areas into one area */
+__global__ void sumAreas(const int numAreas, const double *dev_areas,
+    double *dev_area) {
+  __shared__ double areas[THREADS_PER_BLOCK];
+  double sum = 0.0;
   int i = 0;
 
-  if (areas == NULL) {
-    fprintf(stderr, "malloc failed!\n");
+  for (i = threadIdx.x; i < numAreas; i += blockDim.x) {
+    sum += dev_areas[i];
+  }
+  areas[threadIdx.x] = sum;
+
+  reduceBlock(areas);
+
+  if (threadIdx.x == 0) {
+    (*dev_area) = areas[0];
+  }
+}
+
+void calculateMyArea(const int myNumRects, const double width,
+    const int myDispl, double *area) {
+  const int numBlocks = calculateNumBlocks(myNumRects);
+  double *dev_blockAreas;
+  double *dev_area;
+  cudaError_t err;
+
+  err = cudaMalloc((void**)&dev_blockAreas, (numBlocks * sizeof(double)));
+
+  if (err != cudaSuccess) {
+    fprintf(stderr, "cudaMalloc failed: %s\n", cudaGetErrorString(err));
+    exit(EXIT_FAILURE);
   }
 
-  err = cudaMalloc((void**)&dev_areas, (myNumRects * sizeof(double)));
+  err = cudaMalloc((void**)&dev_area, sizeof(double));
 
   if (err != cudaSuccess) {
     fprintf(stderr, "cudaMalloc failed: %s\n", cudaGetErrorString(err));
+    exit(EXIT_FAILURE);
   }
 
-  calculateAreas<<<dimGrid, dimBlock>>>(myNumRects, width, myDispl, dev_areas);
+  calculateAreas<<<numBlocks, THREADS_PER_BLOCK>>>(myNumRects, width, myDispl,
+    dev_blockAreas);
 
-  err = cudaMemcpy(areas, dev_areas, (myNumRects * sizeof(double)),
-    cudaMemcpyDeviceToHost);
+  err = cudaGetLastError();
 
   if (err != cudaSuccess) {
-    fprintf(stderr, "cudaMalloc failed: %s\n", cudaGetErrorString(err));
+    fprintf(stderr, "calculateAreas failed: %s\n", cudaGetErrorString(err));
+    exit(EXIT_FAILURE);
   }
 
-  (*area) = 0.0;
-  for (i = 0; i < myNumRects; i++) {
-    (*area) += areas[i];
+  sumAreas<<<1, THREADS_PER_BLOCK>>>(numBlocks, dev_blockAreas, dev_area);
+
+  err = cudaGetLastError();
+
+  if (err != cudaSuccess) {
+    fprintf(stderr, "sumAreas failed: %s\n", cudaGetErrorString(err));
+    exit(EXIT_FAILURE);
+  }
+
+  err = cudaMemcpy(area, dev_area, sizeof(double), cudaMemcpyDeviceToHost);
+
+  if (err != cudaSuccess) {
+    fprintf(stderr, "cudaMemcpy failed: %s\n", cudaGetErrorString(err));
+    exit(EXIT_FAILURE);
   }
 
-  cudaFree(dev_areas);
+  cudaFree(dev_area);
 
-  free(areas);
+  cudaFree(dev_blockAreas);
 }
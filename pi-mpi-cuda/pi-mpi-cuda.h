@@ -1,2 +1,12 @@
-void calculateArea(const int myNumRects, const double width, const int myDispl,
-    double *area);
+/* Implemented by pi-mpi-cuda.cu (CUDA) and by pi-mpi-cuda-host.c (OpenMP, for
+ * nodes without a GPU) */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void calculateMyArea(const int myNumRects, const double width,
+    const int myDispl, double *area);
+
+#ifdef __cplusplus
+}
+#endif
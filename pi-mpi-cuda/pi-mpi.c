@@ -1,5 +1,6 @@
 #include <mpi.h>     /* MPI_Init(), MPI_Comm_rank(), etc. */
 #include "pi-calc.h" /* calculateHeight() */
+#include "pi-mpi.h" /* setupMPI(), distributeWork(), calculateArea() */
 
 void setupMPI(int *argc, char ***argv, int *myRank, int *numProcs) {
   MPI_Init(&(*argc), &(*argv));
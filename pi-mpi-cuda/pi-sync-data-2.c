@@ -1,4 +1,5 @@
 #include <mpi.h> /* MPI_Reduce() */
+#include "pi-sync-data-2.h" /* syncData() */
 
 void syncData(double *area) {
   double myArea = (*area);
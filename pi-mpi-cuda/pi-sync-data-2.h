@@ -1 +1,9 @@
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 void syncData(double *area);
+
+#ifdef __cplusplus
+}
+#endif
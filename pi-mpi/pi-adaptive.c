@@ -0,0 +1,186 @@
+#include <mpi.h>      /* MPI_Allgatherv() */
+#include <stdio.h>    /* fprintf() */
+#include <stdlib.h>   /* malloc(), realloc(), free(), exit() */
+#include <math.h>     /* fabs() */
+#include "pi-calc.h"  /* calculateHeightAtX() */
+#include "pi-mpi.h"   /* distributeWork() */
+#include "pi-adaptive.h" /* MIN_TOLERANCE, MAX_INTERVALS */
+
+/* Intervals narrower than this are accepted whatever their error estimate */
+#define MIN_WIDTH 1e-15
+
+/* Number of doubles describing an interval: a, b, area, error */
+#define INTERVAL_SIZE 4
+
+/* Abscissae and weights of the 15-point Kronrod rule and of the 7-point Gauss
+ * rule it extends, on [-1, 1] (from QUADPACK's qk15) */
+static const double xgk[8] = {
+  0.991455371120812639206854697526329, 0.949107912342758524526189684047851,
+  0.864864423359769072789712788640926, 0.741531185599394439863864773280788,
+  0.586087235467691130294144845693013, 0.405845151377397166906606412076961,
+  0.207784955007898467600689403773245, 0.000000000000000000000000000000000
+};
+static const double wgk[8] = {
+  0.022935322010529224963732008058970, 0.063092092629978553290700663189204,
+  0.104790010322250183839876322541518, 0.140653259715525918745189590510238,
+  0.169004726639267902826583426598550, 0.190350578064785409913256402421014,
+  0.204432940075298892414161999234649, 0.209482141084727828012999174891714
+};
+static const double wg[4] = {
+  0.129484966168869693270611432679082, 0.279705391489276667901467771423780,
+  0.381830050505118944950369775488975, 0.417959183673469387755102040816327
+};
+
+/* Apply the 15-point Kronrod rule to [a, b]; the difference from the embedded
+ * 7-point Gauss rule estimates the error */
+static void integrateInterval(const double a, const double b, double *area,
+    double *error) {
+  const double center = (0.5 * (a + b));
+  const double halfWidth = (0.5 * (b - a));
+  double heightLeft = 0.0;
+  double heightRight = 0.0;
+  double kronrod = 0.0;
+  double gauss = 0.0;
+  int j = 0;
+
+  calculateHeightAtX(center, &heightLeft);
+  kronrod = (wgk[7] * heightLeft);
+  gauss = (wg[3] * heightLeft);
+
+  for (j = 0; j < 7; j++) {
+    calculateHeightAtX((center - (halfWidth * xgk[j])), &heightLeft);
+    calculateHeightAtX((center + (halfWidth * xgk[j])), &heightRight);
+    kronrod += (wgk[j] * (heightLeft + heightRight));
+
+    /* The Gauss abscissae are every other Kronrod abscissa */
+    if ((j % 2) == 1) {
+      gauss += (wg[j / 2] * (heightLeft + heightRight));
+    }
+  }
+
+  (*area) = (halfWidth * kronrod);
+  (*error) = fabs(halfWidth * (kronrod - gauss));
+}
+
+static double *growIntervals(double *intervals, const int count) {
+  intervals = (double*)realloc(intervals,
+    ((count > 0 ? count : 1) * INTERVAL_SIZE * sizeof(double)));
+
+  if (intervals == NULL) {
+    fprintf(stderr, "realloc failed!\n");
+    exit(EXIT_FAILURE);
+  }
+
+  return intervals;
+}
+
+/* Whether an integrated interval's error is within its share of the
+ * tolerance, or it is too narrow to split further */
+static int isAccepted(const double *interval, const double tolerance) {
+  const double width = (interval[1] - interval[0]);
+
+  return (interval[3] <= (tolerance * width)) || (width < MIN_WIDTH);
+}
+
+/* Integrate the quarter circle to within an absolute tolerance.  Each round,
+ * the intervals still to be integrated are split evenly across the processes
+ * with distributeWork(), integrated, and gathered on every process.  Every
+ * process then accepts the same intervals whose error is within their share
+ * of the tolerance (in proportion to their width) and halves the rest for the
+ * next round, so the work follows the singularity at x = 1.  If the next
+ * round would have more than MAX_INTERVALS intervals, every interval is
+ * accepted as it is instead and isConverged is set to 0. */
+void calculateAreaAdaptive(const double tolerance, const int myRank,
+    const int numProcs, double *area, double *error, long *myNumEvals,
+    int *isConverged) {
+  int *recvCounts = (int*)malloc(numProcs * sizeof(int));
+  int *displs = (int*)malloc(numProcs * sizeof(int));
+  double *pending = growIntervals(NULL, 1);
+  double *results = growIntervals(NULL, 1);
+  double *mine = growIntervals(NULL, 1);
+  int numPending = 1;
+  int numNext = 0;
+  int numRejected = 0;
+  int myNumIntervals = 0;
+  int myDispl = 0;
+  int i = 0;
+  int proc = 0;
+  double a = 0.0;
+  double b = 0.0;
+
+  if ((recvCounts == NULL) || (displs == NULL)) {
+    fprintf(stderr, "malloc failed!\n");
+    exit(EXIT_FAILURE);
+  }
+
+  (*area) = 0.0;
+  (*error) = 0.0;
+  (*myNumEvals) = 0;
+  (*isConverged) = 1;
+
+  pending[0] = 0.0;
+  pending[1] = 1.0;
+
+  while (numPending > 0) {
+    for (proc = 0; proc < numProcs; proc++) {
+      distributeWork(numPending, proc, numProcs, &recvCounts[proc],
+        &displs[proc]);
+      recvCounts[proc] *= INTERVAL_SIZE;
+      displs[proc] *= INTERVAL_SIZE;
+    }
+    distributeWork(numPending, myRank, numProcs, &myNumIntervals, &myDispl);
+
+    mine = growIntervals(mine, myNumIntervals);
+    for (i = 0; i < myNumIntervals; i++) {
+      a = pending[(myDispl + i) * INTERVAL_SIZE];
+      b = pending[(myDispl + i) * INTERVAL_SIZE + 1];
+      mine[i * INTERVAL_SIZE] = a;
+      mine[i * INTERVAL_SIZE + 1] = b;
+      integrateInterval(a, b, &mine[i * INTERVAL_SIZE + 2],
+        &mine[i * INTERVAL_SIZE + 3]);
+    }
+    (*myNumEvals) += (15 * myNumIntervals);
+
+    results = growIntervals(results, numPending);
+    MPI_Allgatherv(mine, (myNumIntervals * INTERVAL_SIZE), MPI_DOUBLE,
+      results, recvCounts, displs, MPI_DOUBLE, MPI_COMM_WORLD);
+
+    /* Stop refining if the next round would be too big */
+    numRejected = 0;
+    for (i = 0; i < numPending; i++) {
+      numRejected += !isAccepted(&results[i * INTERVAL_SIZE], tolerance);
+    }
+    if (numRejected > (MAX_INTERVALS / 2)) {
+      (*isConverged) = 0;
+    }
+
+    /* Accept converged intervals, split the others in half */
+    pending = growIntervals(pending, (2 * numRejected));
+    numNext = 0;
+    for (i = 0; i < numPending; i++) {
+      a = results[i * INTERVAL_SIZE];
+      b = results[i * INTERVAL_SIZE + 1];
+
+      if (!(*isConverged) || isAccepted(&results[i * INTERVAL_SIZE],
+            tolerance)) {
+        (*area) += results[i * INTERVAL_SIZE + 2];
+        (*error) += results[i * INTERVAL_SIZE + 3];
+      }
+      else {
+        pending[numNext * INTERVAL_SIZE] = a;
+        pending[numNext * INTERVAL_SIZE + 1] = (0.5 * (a + b));
+        numNext++;
+        pending[numNext * INTERVAL_SIZE] = (0.5 * (a + b));
+        pending[numNext * INTERVAL_SIZE + 1] = b;
+        numNext++;
+      }
+    }
+    numPending = numNext;
+  }
+
+  free(mine);
+  free(results);
+  free(pending);
+  free(displs);
+  free(recvCounts);
+}
@@ -0,0 +1,12 @@
+/* Tolerances below this are lost to rounding: the areas of the intervals and
+ * the heights near x = 1 are only accurate to about one part in 1e16, and the
+ * result drifts from pi while the estimated error keeps shrinking */
+#define MIN_TOLERANCE 1e-13
+
+/* Most intervals integrated in one round; a round that would need more stops
+ * the refinement, and the estimated error reached so far is reported */
+#define MAX_INTERVALS (1 << 20)
+
+void calculateAreaAdaptive(const double tolerance, const int myRank,
+    const int numProcs, double *area, double *error, long *myNumEvals,
+    int *isConverged);
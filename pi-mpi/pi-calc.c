@@ -1,10 +1,13 @@
 #include <float.h> /* DBL_EPSILON and LDBL_DIG */
 #include <math.h>  /* sqrt() */
 
-void calculateHeight(const int i, const double width, double *height) {
-  const double x = (i * width);
+void calculateHeightAtX(const double x, double *height) {
   const double heightSq = (1.0 - (x * x));
 
   /* Prevent nan value for sqrt() */
   (*height) = (heightSq < DBL_EPSILON) ? (0.0) : (sqrt(heightSq));
 }
+
+void calculateHeight(const int i, const double width, double *height) {
+  calculateHeightAtX((i * width), &(*height));
+}
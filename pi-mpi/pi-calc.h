@@ -1 +1,2 @@
 void calculateHeight(const int i, const double width, double *height);
+void calculateHeightAtX(const double x, double *height);
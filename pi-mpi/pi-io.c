@@ -1,7 +1,9 @@
 #include <unistd.h> /* getopt() */
-#include <stdlib.h> /* atoi(), exit(), EXIT_FAILURE */
+#include <stdlib.h> /* atoi(), strtod(), strtol(), exit(), EXIT_FAILURE */
 #include <stdio.h>  /* fprintf(), printf() */
 #include <float.h>  /* LDBL_DIG */
+#include "pi-sync-data-1.h" /* SYNC_LINEAR, SYNC_STRATEGY_COUNT */
+#include "pi-adaptive.h" /* MIN_TOLERANCE */
 
 void getUserOptions(int argc, char **argv, int *numRects) {
   char c;
@@ -22,6 +24,73 @@ void getUserOptions(int argc, char **argv, int *numRects) {
   argv += optind;
 }
 
+static void printSyncUsageAndExit(char **argv) {
+  fprintf(stderr, "Usage: ");
+  fprintf(stderr, "%s [-r numRects] [-s syncStrategy]\n", argv[0]);
+  fprintf(stderr, "  syncStrategy: 0 linear (default), 1 binomial tree, "
+    "2 recursive doubling,\n                3 MPI_Ireduce, "
+    "4 MPI_Allreduce\n");
+  exit(EXIT_FAILURE);
+}
+
+void getUserSyncOptions(int argc, char **argv, int *numRects,
+    int *syncStrategy) {
+  char c;
+  char *end;
+
+  while ((c = getopt(argc, argv, "r:s:")) != -1) {
+    switch(c) {
+      case 'r':
+        (*numRects) = atoi(optarg);
+        break;
+      case 's':
+        /* Only the strategies listed in the usage are accepted */
+        (*syncStrategy) = (int)strtol(optarg, &end, 10);
+        if (end == optarg || *end != '\0' ||
+            (*syncStrategy) < SYNC_LINEAR ||
+            (*syncStrategy) >= SYNC_STRATEGY_COUNT) {
+          fprintf(stderr, "%s: unknown syncStrategy '%s'\n", argv[0],
+            optarg);
+          printSyncUsageAndExit(argv);
+        }
+        break;
+      case '?':
+      default:
+        printSyncUsageAndExit(argv);
+    }
+  }
+  argc -= optind;
+  argv += optind;
+}
+
+void getUserAdaptiveOptions(int argc, char **argv, double *tolerance) {
+  char c;
+  char *end;
+
+  while ((c = getopt(argc, argv, "t:")) != -1) {
+    switch(c) {
+      case 't':
+        /* Anything but a number from MIN_TOLERANCE up (nan included) gets
+         * the usage */
+        (*tolerance) = strtod(optarg, &end);
+        if (end != optarg && *end == '\0' &&
+            ((*tolerance) >= MIN_TOLERANCE)) {
+          break;
+        }
+        fprintf(stderr, "%s: tolerance must be at least %g\n", argv[0],
+          MIN_TOLERANCE);
+        /* Fall through */
+      case '?':
+      default:
+        fprintf(stderr, "Usage: ");
+        fprintf(stderr, "%s [-t tolerance]\n", argv[0]);
+        exit(EXIT_FAILURE);
+    }
+  }
+  argc -= optind;
+  argv += optind;
+}
+
 void calculateAndPrintPi(const double area) {
   printf("%.*f\n", LDBL_DIG, (4.0 * area));
 }
@@ -1,3 +1,6 @@
 void getUserOptions(int argc, char **argv, int *numRects);
+void getUserSyncOptions(int argc, char **argv, int *numRects,
+    int *syncStrategy);
+void getUserAdaptiveOptions(int argc, char **argv, double *tolerance);
 
 void calculateAndPrintPi(const double area);
@@ -5,15 +5,24 @@
  *
  * When running the program, the number of rectangles can be passed using the
  * -r option, e.g. 'pi-mpi-1 -r X', where X is the number of rectangles.
+ *
+ * The strategy used to sum the areas onto rank 0 can be passed using the -s
+ * option, e.g. 'pi-mpi-1 -s 1' for a binomial tree (see pi-sync-data-1.h).
+ * Rank 0 prints the time spent synchronizing after the value of pi.
  */
 
 /*************
  * LIBRARIES *
  *************/
 #include <mpi.h> /* MPI_Send(), MPI_Recv(), etc. */
-#include "pi-io.h" /* getUserOptions(), calculateAndPrintPi() */
+#include <stdio.h> /* printf() */
+#include "pi-io.h" /* getUserSyncOptions(), calculateAndPrintPi() */
 #include "pi-mpi.h" /* setupMPI(), distributeWork(), calculateArea() */
-#include "pi-sync-data-1.h" /* syncData() */
+#include "pi-sync-data-1.h" /* startSyncData(), syncData(), getSyncTime() */
+
+/* With SYNC_IREDUCE, the last 1/TAIL_DIVISOR of each process's rectangles are
+ * calculated while the reduction of the rest is in progress */
+#define TAIL_DIVISOR 8
 
 /************************
  * FUNCTION DEFINITIONS *
@@ -25,19 +34,47 @@ int main(int argc, char **argv) {
   int numProcs = 1;
   int myNumRects = 0;
   int myDispl = 0;
+  int myTailRects = 0;
+  int syncStrategy = SYNC_LINEAR;
+  double syncTime = 0.0;
+  double maxSyncTime = 0.0;
+  double sumSyncTime = 0.0;
 
   setupMPI(&argc, &argv, &myRank, &numProcs);
 
-  getUserOptions(argc, argv, &numRects);
+  getUserSyncOptions(argc, argv, &numRects, &syncStrategy);
+
+  setSyncStrategy(syncStrategy);
 
   distributeWork(numRects, myRank, numProcs, &myNumRects, &myDispl);
 
-  calculateArea(numRects, myNumRects, (1.0 / numRects), myDispl, &area);
+  if (syncStrategy == SYNC_IREDUCE) {
+    myTailRects = (myNumRects / TAIL_DIVISOR);
+  }
+
+  calculateArea(numRects, (myNumRects - myTailRects), (1.0 / numRects),
+    myDispl, &area);
+
+  startSyncData(&area);
+
+  if (syncStrategy == SYNC_IREDUCE) {
+    calculateArea(numRects, myTailRects, (1.0 / numRects),
+      (myDispl + myNumRects - myTailRects), &area);
+  }
 
   syncData(myRank, numProcs, &area);
 
+  syncTime = getSyncTime();
+  MPI_Reduce(&syncTime, &maxSyncTime, 1, MPI_DOUBLE, MPI_MAX, 0,
+    MPI_COMM_WORLD);
+  MPI_Reduce(&syncTime, &sumSyncTime, 1, MPI_DOUBLE, MPI_SUM, 0,
+    MPI_COMM_WORLD);
+
   if (myRank == 0) {
     calculateAndPrintPi(area);
+    printf("syncData (%s, %d processes): max %e s, mean %e s\n",
+      getSyncStrategyName(syncStrategy), numProcs, maxSyncTime,
+      (sumSyncTime / numProcs));
   }
 
   MPI_Finalize();
@@ -0,0 +1,58 @@
+/* Pi - MPI adaptive version (uses Gauss-Kronrod quadrature)
+ *
+ * Approximate pi using adaptive 15-point Gauss-Kronrod quadrature under a
+ * quarter unit circle.  Instead of a fixed number of uniform rectangles, the
+ * interval is halved only where the error estimate is too large, which is
+ * near x = 1 where the slope of the circle is infinite.
+ *
+ * When running the program, the absolute tolerance for the area can be
+ * passed using the -t option, e.g. 'pi-mpi-adaptive -t X', from MIN_TOLERANCE
+ * up.  Rank 0 prints pi, its estimated error, and the number of function
+ * evaluations used, and warns if the tolerance was not reached within
+ * MAX_INTERVALS intervals.
+ */
+
+/*************
+ * LIBRARIES *
+ *************/
+#include <mpi.h> /* MPI_Finalize(), MPI_Reduce() */
+#include <stdio.h> /* printf() */
+#include "pi-io.h" /* getUserAdaptiveOptions(), calculateAndPrintPi() */
+#include "pi-mpi.h" /* setupMPI() */
+#include "pi-adaptive.h" /* calculateAreaAdaptive() */
+
+/************************
+ * FUNCTION DEFINITIONS *
+ ************************/
+int main(int argc, char **argv) {
+  double tolerance = 1e-10;
+  double area = 0.0;
+  double error = 0.0;
+  int myRank = 0;
+  int numProcs = 1;
+  long myNumEvals = 0;
+  long numEvals = 0;
+  int isConverged = 1;
+
+  setupMPI(&argc, &argv, &myRank, &numProcs);
+
+  getUserAdaptiveOptions(argc, argv, &tolerance);
+
+  calculateAreaAdaptive(tolerance, myRank, numProcs, &area, &error,
+    &myNumEvals, &isConverged);
+
+  MPI_Reduce(&myNumEvals, &numEvals, 1, MPI_LONG, MPI_SUM, 0, MPI_COMM_WORLD);
+
+  if (myRank == 0) {
+    calculateAndPrintPi(area);
+    printf("estimated error %e, %ld evaluations\n", (4.0 * error), numEvals);
+    if (!isConverged) {
+      fprintf(stderr, "Tolerance %e not reached within %d intervals\n",
+        tolerance, MAX_INTERVALS);
+    }
+  }
+
+  MPI_Finalize();
+
+  return 0;
+}
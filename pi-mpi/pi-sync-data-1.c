@@ -1,8 +1,45 @@
-#include <mpi.h> /* MPI_Recv(), MPI_Send(), etc. */
+#include <mpi.h> /* MPI_Recv(), MPI_Send(), MPI_Wtime(), etc. */
+#include "pi-sync-data-1.h" /* SYNC_LINEAR, etc. */
 
 #define TAG 0
 
-void syncData(const int myRank, const int numProcs, double *myArea) {
+static int syncStrategy = SYNC_LINEAR;
+
+/* Seconds this process has spent inside startSyncData() and syncData() */
+static double syncTime = 0.0;
+
+/* The head area reduced by MPI_Ireduce() while the tail is being calculated */
+static double headArea = 0.0;
+static double headSum = 0.0;
+static MPI_Request headRequest = MPI_REQUEST_NULL;
+
+void setSyncStrategy(const int strategy) {
+  syncStrategy = strategy;
+}
+
+const char *getSyncStrategyName(const int strategy) {
+  switch (strategy) {
+    case SYNC_LINEAR:
+      return "linear";
+    case SYNC_BINOMIAL_TREE:
+      return "binomial tree";
+    case SYNC_RECURSIVE_DOUBLING:
+      return "recursive doubling";
+    case SYNC_IREDUCE:
+      return "MPI_Ireduce";
+    case SYNC_ALLREDUCE:
+      return "MPI_Allreduce";
+    default:
+      return "unknown";
+  }
+}
+
+double getSyncTime() {
+  return syncTime;
+}
+
+/* Rank 0 receives from every other process in turn: O(p) steps at rank 0 */
+static void syncLinear(const int myRank, const int numProcs, double *myArea) {
   int i;
   double theirArea;
 
@@ -14,6 +51,122 @@ void syncData(const int myRank, const int numProcs, double *myArea) {
     }
   }
   else {
-    MPI_Send(&(*myArea), 1, MPI_DOUBLE, TAG, 0, MPI_COMM_WORLD);
+    MPI_Send(&(*myArea), 1, MPI_DOUBLE, 0, TAG, MPI_COMM_WORLD);
   }
 }
+
+/* In step k, each process whose rank has bit k set sends its partial sum to
+ * the process 2^k below it and drops out: ceil(log2(p)) steps at rank 0 */
+static void syncBinomialTree(const int myRank, const int numProcs,
+    double *myArea) {
+  int mask;
+  double theirArea;
+
+  for (mask = 1; mask < numProcs; mask <<= 1) {
+    if (myRank & mask) {
+      MPI_Send(&(*myArea), 1, MPI_DOUBLE, (myRank - mask), TAG,
+        MPI_COMM_WORLD);
+      break;
+    }
+    else if ((myRank + mask) < numProcs) {
+      MPI_Recv(&theirArea, 1, MPI_DOUBLE, (myRank + mask), TAG,
+        MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+      (*myArea) += theirArea;
+    }
+  }
+}
+
+/* Every process exchanges its partial sum with partner (rank ^ 2^k) in step
+ * k, so all processes end with the same total.  Processes beyond the largest
+ * power of 2 first fold into a partner and get the total back at the end. */
+static void syncRecursiveDoubling(const int myRank, const int numProcs,
+    double *myArea) {
+  int pow2 = 1;
+  int mask;
+  int numExtra;
+  double myPartial;
+  double theirArea;
+
+  while ((pow2 * 2) <= numProcs) {
+    pow2 *= 2;
+  }
+  numExtra = (numProcs - pow2);
+
+  if (myRank >= pow2) {
+    MPI_Send(&(*myArea), 1, MPI_DOUBLE, (myRank - pow2), TAG, MPI_COMM_WORLD);
+    MPI_Recv(&(*myArea), 1, MPI_DOUBLE, (myRank - pow2), TAG, MPI_COMM_WORLD,
+      MPI_STATUS_IGNORE);
+    return;
+  }
+
+  if (myRank < numExtra) {
+    MPI_Recv(&theirArea, 1, MPI_DOUBLE, (myRank + pow2), TAG, MPI_COMM_WORLD,
+      MPI_STATUS_IGNORE);
+    (*myArea) += theirArea;
+  }
+
+  for (mask = 1; mask < pow2; mask <<= 1) {
+    myPartial = (*myArea);
+    MPI_Sendrecv(&myPartial, 1, MPI_DOUBLE, (myRank ^ mask), TAG,
+      &theirArea, 1, MPI_DOUBLE, (myRank ^ mask), TAG, MPI_COMM_WORLD,
+      MPI_STATUS_IGNORE);
+    (*myArea) += theirArea;
+  }
+
+  if (myRank < numExtra) {
+    MPI_Send(&(*myArea), 1, MPI_DOUBLE, (myRank + pow2), TAG, MPI_COMM_WORLD);
+  }
+}
+
+/* Post the reduction of the area calculated so far and reset the process's
+ * area so the caller can calculate the tail while the reduction progresses.
+ * Does nothing unless the strategy is SYNC_IREDUCE. */
+void startSyncData(double *myArea) {
+  const double startTime = MPI_Wtime();
+
+  if (syncStrategy == SYNC_IREDUCE) {
+    headArea = (*myArea);
+    MPI_Ireduce(&headArea, &headSum, 1, MPI_DOUBLE, MPI_SUM, 0,
+      MPI_COMM_WORLD, &headRequest);
+    (*myArea) = 0.0;
+  }
+
+  syncTime += (MPI_Wtime() - startTime);
+}
+
+void syncData(const int myRank, const int numProcs, double *myArea) {
+  const double startTime = MPI_Wtime();
+  MPI_Request requests[2];
+  double tailArea;
+  double tailSum = 0.0;
+
+  switch (syncStrategy) {
+    case SYNC_BINOMIAL_TREE:
+      syncBinomialTree(myRank, numProcs, &(*myArea));
+      break;
+    case SYNC_RECURSIVE_DOUBLING:
+      syncRecursiveDoubling(myRank, numProcs, &(*myArea));
+      break;
+    case SYNC_IREDUCE:
+      tailArea = (*myArea);
+      requests[0] = headRequest;
+      MPI_Ireduce(&tailArea, &tailSum, 1, MPI_DOUBLE, MPI_SUM, 0,
+        MPI_COMM_WORLD, &requests[1]);
+      MPI_Waitall(2, requests, MPI_STATUSES_IGNORE);
+      headRequest = MPI_REQUEST_NULL;
+      if (myRank == 0) {
+        (*myArea) = (headSum + tailSum);
+      }
+      break;
+    case SYNC_ALLREDUCE:
+      MPI_Allreduce(MPI_IN_PLACE, &(*myArea), 1, MPI_DOUBLE, MPI_SUM,
+        MPI_COMM_WORLD);
+      break;
+    case SYNC_LINEAR:
+    default:
+      syncLinear(myRank, numProcs, &(*myArea));
+      break;
+  }
+
+  syncTime += (MPI_Wtime() - startTime);
+}
@@ -1 +1,13 @@
+/* Strategies for summing every process's area onto rank 0 */
+#define SYNC_LINEAR 0             /* rank 0 receives from each process */
+#define SYNC_BINOMIAL_TREE 1      /* MPI_Send()/MPI_Recv() along a tree */
+#define SYNC_RECURSIVE_DOUBLING 2 /* MPI_Sendrecv() with partner rank^mask */
+#define SYNC_IREDUCE 3            /* MPI_Ireduce() overlapped with the tail */
+#define SYNC_ALLREDUCE 4          /* MPI_Allreduce() */
+#define SYNC_STRATEGY_COUNT 5
+
+void setSyncStrategy(const int strategy);
+const char *getSyncStrategyName(const int strategy);
+void startSyncData(double *myArea);
 void syncData(const int myRank, const int numProcs, double *myArea);
+double getSyncTime();